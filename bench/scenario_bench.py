@@ -0,0 +1,275 @@
+#! /usr/bin/env python
+"""End-to-end timing of the mbmore sample scenarios.
+
+Scaled copies of src/multi_final_sample.xml (states, sinks and enrichment
+facilities per state) and src/tmp/cascade_tests.xml (sinks and enrichment
+facilities) are run with cyclus at each requested size and duration. Wall
+time, peak RSS and time per timestep of each run are written to a JSON file,
+which can be compared with the results of another commit:
+
+    python bench/scenario_bench.py --output new.json --compare old.json
+
+The mbmore archetypes are loaded by cyclus as usual, so install the build to
+be measured first (or point --cyclus-path at it).
+"""
+from __future__ import print_function
+
+import copy
+import datetime
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+import xml.etree.ElementTree as ET
+
+try:
+    import argparse as ap
+except ImportError:
+    import pyne._argparse as ap
+
+absexpanduser = lambda x: os.path.abspath(os.path.expanduser(x))
+
+root_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+
+SCENARIOS = {
+    'multi': os.path.join(root_dir, 'src', 'multi_final_sample.xml'),
+    'cascade': os.path.join(root_dir, 'src', 'tmp', 'cascade_tests.xml'),
+}
+
+
+def int_list(s):
+    return [int(x) for x in s.split(',')]
+
+
+def set_text(elem, path, value):
+    for e in elem.iter(path):
+        e.text = str(value)
+
+
+def set_number(inst, prototype, number):
+    """Number of a prototype in an institution's initial facility list"""
+    for entry in inst.iter('entry'):
+        if entry.findtext('prototype').strip() == prototype:
+            entry.find('number').text = str(number)
+
+
+def scale_multi(tree, n_states, n_sinks, n_enrich):
+    """States are copies of the sample states (in turn), each the enemy of the
+    next one, with n_sinks LEU sinks and n_enrich enrichment facilities."""
+    region = tree.getroot().find('region')
+    templates = region.findall('institution')
+    for inst in templates:
+        region.remove(inst)
+
+    names = ['State%d' % i for i in range(n_states)]
+    relations = region.find('config/InteractRegion/p_conflict_relations')
+    for item in list(relations):
+        relations.remove(item)
+    for i, name in enumerate(names):
+        enemy = names[(i + 1) % n_states]
+        item = ET.SubElement(relations, 'item')
+        ET.SubElement(item, 'primary_state').text = name
+        pair = ET.SubElement(ET.SubElement(item, 'pair_state'), 'item')
+        ET.SubElement(pair, 'name').text = enemy
+        ET.SubElement(pair, 'relation').text = '-1'
+
+        inst = copy.deepcopy(templates[i % len(templates)])
+        inst.find('name').text = name
+        set_number(inst, 'LEU', n_sinks)
+        set_number(inst, 'Enrichment', n_enrich)
+        for factor in inst.iter('item'):
+            if (factor.findtext('factor') or '').strip() == 'Conflict':
+                factor.find('function/name').text = enemy
+        region.append(inst)
+
+
+def scale_cascade(tree, n_states, n_sinks, n_enrich):
+    """The single institution gets n_sinks of each sink and n_enrich of each
+    enrichment facility. There are no states in this scenario."""
+    inst = tree.getroot().find('region/institution')
+    for proto in ('LEU', 'covert_HEU'):
+        set_number(inst, proto, n_sinks)
+    for proto in ('Enrichment', 'Cascade'):
+        set_number(inst, proto, n_enrich)
+
+
+SCALERS = {'multi': scale_multi, 'cascade': scale_cascade}
+
+
+def write_input(scenario, n_states, n_sinks, n_enrich, duration, seed, path):
+    tree = ET.parse(SCENARIOS[scenario])
+    SCALERS[scenario](tree, n_states, n_sinks, n_enrich)
+    set_text(tree.getroot(), 'duration', duration)
+    # fixed seeds so that every commit runs the same trades
+    set_text(tree.getroot(), 'rng_seed', seed)
+    tree.write(path)
+
+
+def run_cyclus(args, infile, outfile):
+    """Returns the exit code, wall time (s) and peak RSS (MB) of one run"""
+    cmd = [args.cyclus, '-o', outfile, infile]
+    env = dict(os.environ)
+    if args.cyclus_path:
+        env['CYCLUS_PATH'] = os.pathsep.join(
+            [args.cyclus_path] + [p for p in [env.get('CYCLUS_PATH')] if p])
+    with open(os.devnull, 'w') as devnull:
+        start = time.time()
+        proc = subprocess.Popen(cmd, stdout=devnull, stderr=devnull, env=env)
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.time() - start
+    rc = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1
+    proc.returncode = rc
+    # ru_maxrss is in kB on Linux and in bytes on macOS
+    rss_kb = usage.ru_maxrss / (1024.0 if sys.platform == 'darwin' else 1.0)
+    return rc, wall, rss_kb / 1024.0
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(
+            ['git', 'rev-parse', 'HEAD'], cwd=root_dir).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def cyclus_version(args):
+    try:
+        out = subprocess.check_output([args.cyclus, '--version'])
+        return out.decode().splitlines()[0].strip()
+    except (OSError, subprocess.CalledProcessError, IndexError):
+        return None
+
+
+def run_key(run):
+    return (run['scenario'], run['states'], run['sinks'], run['enrich'],
+            run['duration'])
+
+
+def bench(args):
+    runs = []
+    workdir = tempfile.mkdtemp(prefix='mbmore_bench_')
+    try:
+        for scenario in args.scenarios:
+            # the cascade scenario has a single (null) institution
+            states = args.states if scenario == 'multi' else [1]
+            for n_states in states:
+                for n_sinks in args.sinks:
+                    for n_enrich in args.enrich:
+                        for duration in args.duration:
+                            name = '%s_%d_%d_%d_%d' % (scenario, n_states,
+                                                       n_sinks, n_enrich,
+                                                       duration)
+                            infile = os.path.join(workdir, name + '.xml')
+                            outfile = os.path.join(workdir, name + '.sqlite')
+                            write_input(scenario, n_states, n_sinks, n_enrich,
+                                        duration, args.seed, infile)
+                            walls = []
+                            rss = 0
+                            rc = 0
+                            for _ in range(args.repeat):
+                                if os.path.exists(outfile):
+                                    os.remove(outfile)
+                                rc, wall, peak = run_cyclus(args, infile,
+                                                            outfile)
+                                walls.append(wall)
+                                rss = max(rss, peak)
+                                if rc != 0:
+                                    break
+                            wall = min(walls)
+                            run = {'scenario': scenario, 'states': n_states,
+                                   'sinks': n_sinks, 'enrich': n_enrich,
+                                   'duration': duration, 'returncode': rc,
+                                   'wall_s': wall,
+                                   's_per_timestep': wall / duration,
+                                   'peak_rss_mb': rss}
+                            runs.append(run)
+                            print('%-28s %s %9.3f s %9.5f s/step %8.1f MB' %
+                                  (name, 'ok  ' if rc == 0 else 'FAIL', wall,
+                                   run['s_per_timestep'], rss))
+                            if rc != 0 and args.keep_failed:
+                                shutil.copy(infile, os.getcwd())
+    finally:
+        shutil.rmtree(workdir)
+    return runs
+
+
+def compare(runs, path):
+    with open(path) as f:
+        old = json.load(f)
+    old_runs = dict((run_key(r), r) for r in old['runs'])
+    print('\ncompared with %s (commit %s)' % (path, old.get('commit')))
+    for run in runs:
+        prev = old_runs.get(run_key(run))
+        if prev is None or prev['returncode'] != 0 or run['returncode'] != 0:
+            continue
+        ratio = lambda new, old: new / old if old > 0 else float('nan')
+        print('%-28s wall x%.2f  rss x%.2f' % (
+            '%s_%d_%d_%d_%d' % run_key(run),
+            ratio(run['wall_s'], prev['wall_s']),
+            ratio(run['peak_rss_mb'], prev['peak_rss_mb'])))
+
+
+def main():
+    description = 'Time the mbmore sample scenarios at several sizes.'
+    parser = ap.ArgumentParser(description=description)
+    parser.add_argument('--scenarios', type=lambda s: s.split(','),
+                        default=sorted(SCENARIOS.keys()),
+                        help='comma separated list of: ' +
+                        ', '.join(sorted(SCENARIOS.keys())))
+    parser.add_argument('--states', type=int_list, default=[3, 6, 12],
+                        help='numbers of states (multi scenario only)')
+    parser.add_argument('--sinks', type=int_list, default=[1, 4],
+                        help='numbers of each sink prototype per institution')
+    parser.add_argument('--enrich', type=int_list, default=[1, 4],
+                        help='numbers of each enrichment prototype per '
+                        'institution')
+    parser.add_argument('--duration', type=int_list, default=[10, 100],
+                        help='simulation durations (timesteps)')
+    parser.add_argument('--repeat', type=int, default=1,
+                        help='runs of each input; the fastest is kept')
+    parser.add_argument('--seed', type=int, default=1,
+                        help='rng_seed given to every random archetype')
+    parser.add_argument('--cyclus', default='cyclus',
+                        help='cyclus executable')
+    parser.add_argument('--cyclus-path', type=absexpanduser, default=None,
+                        help='directory prepended to CYCLUS_PATH, eg. the '
+                        'install prefix of the build to measure')
+    parser.add_argument('--output', type=absexpanduser,
+                        default='scenario_bench.json',
+                        help='JSON results file')
+    parser.add_argument('--compare', type=absexpanduser, default=None,
+                        help='JSON results of another commit to compare with')
+    parser.add_argument('--keep-failed', action='store_true',
+                        help='copy the inputs of failed runs to the current '
+                        'directory')
+    args = parser.parse_args()
+
+    for scenario in args.scenarios:
+        if scenario not in SCENARIOS:
+            parser.error('unknown scenario ' + scenario)
+    if min(args.states) < 2 and 'multi' in args.scenarios:
+        parser.error('the multi scenario needs at least 2 states')
+
+    runs = bench(args)
+    results = {
+        'commit': git_commit(),
+        'date': datetime.datetime.now().isoformat(),
+        'host': platform.node(),
+        'cyclus': cyclus_version(args),
+        'runs': runs,
+    }
+    with open(args.output, 'w') as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print('results written to ' + args.output)
+
+    if args.compare:
+        compare(runs, args.compare)
+    return 0 if all(r['returncode'] == 0 for r in runs) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -2,6 +2,7 @@
 #include "CascadeEnrich.h"
 #include "behavior_functions.h"
 #include "enrich_functions.h"
+#include "perf_timers.h"
 #include "sim_init.h"
 
 #include <algorithm>
@@ -32,7 +33,11 @@ namespace mbmore {
   feed_commod(""),
   product_commod(""),
   tails_commod(""),
-  order_prefs(true) {}
+  order_prefs(true),
+  record_interval(0),
+  interval_start_(0),
+  interval_feed_(0),
+  interval_swu_(0) {}
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 CascadeEnrich::~CascadeEnrich() {}
 
@@ -87,6 +92,7 @@ void CascadeEnrich::Build(cyclus::Agent* parent) {
   SwuCapacity(cascade_info.first * FlowPerMon(design_delU));
 
   Facility::Build(parent);
+  interval_start_ = context()->time();
   if (initial_feed > 0) {
     inventory.Push(
       Material::Create(
@@ -100,6 +106,7 @@ void CascadeEnrich::Build(cyclus::Agent* parent) {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void CascadeEnrich::Tick() {
+  MBMORE_PERF_TICK("CascadeEnrich", context());
 
  current_swu_capacity = SwuCapacity();
  
@@ -107,6 +114,7 @@ void CascadeEnrich::Tick() {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void CascadeEnrich::Tock() {
+  MBMORE_PERF_TOCK("CascadeEnrich", context());
   using cyclus::toolkit::RecordTimeSeries;
 
   LOG(cyclus::LEV_INFO4, "EnrFac") << prototype() << " used "
@@ -116,11 +124,27 @@ void CascadeEnrich::Tock() {
                                    << intra_timestep_feed_ << " feed";
   RecordTimeSeries<cyclus::toolkit::ENRICH_FEED>(this, intra_timestep_feed_);
 
+  // the last interval ends early at the end of the simulation
+  int next_step = context()->time() + 1;
+  if ((record_interval > 0) &&
+      ((next_step - interval_start_ >= record_interval) ||
+       (next_step >= context()->sim_info().duration))) {
+    RecordInterval_(next_step);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void CascadeEnrich::Decommission() {
+  if (record_interval > 0) {
+    RecordInterval_(context()->time());
+  }
+  cyclus::Facility::Decommission();
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
 CascadeEnrich::GetMatlRequests() {
+  MBMORE_PERF_SCOPE("CascadeEnrich", "GetMatlRequests");
   using cyclus::Material;
   using cyclus::RequestPortfolio;
   using cyclus::Request;
@@ -142,6 +166,7 @@ CascadeEnrich::GetMatlRequests() {
 //  U-235 content
 void CascadeEnrich::AdjustMatlPrefs(
     cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_PERF_SCOPE("CascadeEnrich", "AdjustMatlPrefs");
   using cyclus::Bid;
   using cyclus::Material;
   using cyclus::Request;
@@ -242,6 +267,7 @@ void CascadeEnrich::AddMat_(cyclus::Material::Ptr mat) {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>
 CascadeEnrich::GetMatlBids(cyclus::CommodMap<cyclus::Material>::type& out_requests) {
+  MBMORE_PERF_SCOPE("CascadeEnrich", "GetMatlBids");
   using cyclus::Bid;
   using cyclus::BidPortfolio;
   using cyclus::CapacityConstraint;
@@ -318,6 +344,7 @@ void CascadeEnrich::GetMatlTrades(
     const std::vector<cyclus::Trade<cyclus::Material> >& trades,
     std::vector<std::pair<cyclus::Trade<cyclus::Material>,
                           cyclus::Material::Ptr> >& responses) {
+  MBMORE_PERF_SCOPE("CascadeEnrich", "GetMatlTrades");
   using cyclus::Material;
   using cyclus::Trade;
 
@@ -362,6 +389,7 @@ void CascadeEnrich::GetMatlTrades(
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 cyclus::Material::Ptr CascadeEnrich::Enrich_(cyclus::Material::Ptr mat,
                                           double qty) {
+  MBMORE_PERF_SCOPE("CascadeEnrich", "Enrich_");
   using cyclus::Material;
   using cyclus::ResCast;
   using cyclus::toolkit::Assays;
@@ -447,6 +475,12 @@ void CascadeEnrich::RecordEnrichment_(double natural_u, double swu) {
   LOG(cyclus::LEV_DEBUG1, "EnrFac") << "  * Amount: " << natural_u;
   LOG(cyclus::LEV_DEBUG1, "EnrFac") << "  *    SWU: " << swu;
 
+  if (record_interval > 0) {
+    interval_feed_ += natural_u;
+    interval_swu_ += swu;
+    return;
+  }
+
   Context* ctx = Agent::context();
   ctx->NewDatum("Enrichments")
       ->AddVal("ID", id())
@@ -456,6 +490,21 @@ void CascadeEnrich::RecordEnrichment_(double natural_u, double swu) {
       ->Record();
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void CascadeEnrich::RecordInterval_(int next_start) {
+  if ((interval_feed_ > 0) || (interval_swu_ > 0)) {
+    context()->NewDatum("Enrichments")
+      ->AddVal("ID", id())
+      ->AddVal("Time", interval_start_)
+      ->AddVal("Natural_Uranium", interval_feed_)
+      ->AddVal("SWU", interval_swu_)
+      ->Record();
+  }
+  interval_start_ = next_start;
+  interval_feed_ = 0;
+  interval_swu_ = 0;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 cyclus::Material::Ptr CascadeEnrich::Request_() {
   double qty = std::max(0.0, inventory.capacity() - inventory.quantity());
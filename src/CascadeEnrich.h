@@ -150,6 +150,10 @@ class CascadeEnrich : public cyclus::Facility {
   ///  @param time is the time to perform the tock
   virtual void Tock();
 
+  /// Records any enrichment totals not yet written before leaving the
+  /// simulation
+  virtual void Decommission();
+
   /// @brief The Enrichment request Materials of its given
   /// commodity.
   virtual std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
@@ -244,9 +248,14 @@ class CascadeEnrich : public cyclus::Facility {
 
   cyclus::Material::Ptr Enrich_(cyclus::Material::Ptr mat, double qty);
 
-  ///  @brief records and enrichment with the cyclus::Recorder
+  ///  @brief records and enrichment with the cyclus::Recorder, or adds it to
+  ///  the interval totals if record_interval is set
   void RecordEnrichment_(double natural_u, double swu);
 
+  ///  @brief writes one Enrichments row with the totals since interval_start_
+  ///  (if anything was enriched) and starts a new interval at next_start
+  void RecordInterval_(int next_start);
+
   // Set to design_tails at beginning of simulation. Gets reset if
   // facility is used off-design
   double tails_assay;  
@@ -368,6 +377,17 @@ class CascadeEnrich : public cyclus::Facility {
            "so that EF chooses higher U235 content first" }
   bool order_prefs;
 
+  #pragma cyclus var { \
+    "default": 0, \
+    "tooltip": "timesteps per Enrichments row", \
+    "uilabel": "Enrichment Record Interval", \
+    "doc": "If 0, one Enrichments row is recorded for every trade. " \
+           "Otherwise one row is recorded for every record_interval " \
+           "timesteps (in which anything was enriched), with the total " \
+           "natural uranium and SWU used in that interval. The row Time is " \
+           "the first timestep of the interval." }
+  int record_interval;
+
   #pragma cyclus var { \
     "default" : 1.0, \
     "tooltip" : "maximum allowed enrichment fraction", \
@@ -411,6 +431,27 @@ class CascadeEnrich : public cyclus::Facility {
   double intra_timestep_swu_;
   double intra_timestep_feed_;
 
+  // Natural uranium and SWU used since interval_start_, when recording
+  // Enrichments per interval
+  #pragma cyclus var { \
+    "default": 0, "internal": True, \
+    "tooltip": "first timestep of the open Enrichments interval", \
+    "doc": "first timestep of the record_interval interval that has not " \
+           "been recorded yet" }
+  int interval_start_;
+  #pragma cyclus var { \
+    "default": 0, "internal": True, \
+    "tooltip": "natural uranium used in the open interval (kg)", \
+    "doc": "natural uranium used since interval_start_ and not yet " \
+           "recorded in Enrichments" }
+  double interval_feed_;
+  #pragma cyclus var { \
+    "default": 0, "internal": True, \
+    "tooltip": "SWU used in the open interval", \
+    "doc": "SWU used since interval_start_ and not yet recorded in " \
+           "Enrichments" }
+  double interval_swu_;
+
 // END LEGACY
 
 #pragma cyclus var { 'capacity' : 'max_feed_inventory' }
@@ -1,6 +1,12 @@
 // Implements the Region class
 #include "InteractRegion.h"
+#include "StateInst.h"
 #include "behavior_functions.h"
+#include "perf_timers.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
 
 #include <iostream>
 #include <string>
@@ -13,7 +19,11 @@ namespace mbmore {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 InteractRegion::InteractRegion(cyclus::Context* ctx)
-  : cyclus::Region(ctx) {
+  : cyclus::Region(ctx),
+    decision_threads(1),
+    sparse_progress(false),
+    n_states(0),
+    conflict_graph_built(false) {
     //  kind_ = "InteractRegion";
   cyclus::Warn<cyclus::EXPERIMENTAL_WARNING>("the InteractRegion agent is experimental.");
 
@@ -26,13 +36,39 @@ InteractRegion::InteractRegion(cyclus::Context* ctx)
     cyclus::Agent::Build(parent);
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-std::map<std::string, double>
+const std::map<std::string, double>&
   InteractRegion::GetWeights(std::string eqn_type) {
     return wts;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const std::vector<double>&
+  InteractRegion::GetFactorWeights(std::string eqn_type) {
+    return p_factor_wts;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const FactorSet& InteractRegion::GetPresentFactors(std::string eqn_type) {
+    return p_present_ids;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int InteractRegion::FactorId(const std::string& factor) {
+  for (int f = 0; f < column_names.size(); f++) {
+    if (column_names[f] == factor) {
+      return f;
+    }
+  }
+  return -1;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 int InteractRegion::GetNStates() {
-  int n_states = 0;
+  return n_states;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::Tick() {
+  MBMORE_PERF_TICK("InteractRegion", context());
+
+  // States may be added or removed during the sim, so count them once here
+  // rather than every time a state asks.
+  n_states = 0;
   for (std::set<Agent*>::const_iterator inst = children().begin();
        inst != children().end();
        inst++) {
@@ -40,50 +76,22 @@ int InteractRegion::GetNStates() {
       n_states++; 
     }
   }
-  return n_states;
-}
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void InteractRegion::Tick() {
+
+  // Weights and defined factors are fixed for the whole sim. (Checked by
+  // emptiness instead of time so that the registry is also rebuilt when
+  // restarting from a snapshot)
+  if (p_factor_wts.empty()) {
+    BuildFactorRegistry();
+  }
+
+  if (!conflict_graph_built) {
+    BuildConflictGraph();
+  }
 
   // Things to do only at beginning of Simulation
   if (context()->time() == 0){
     
-    // Create conflict score map
-    BuildScoreMatrix();
-    
-    // Define Master List of column names for the database only once.
-    std::string master_factors [] = { "Auth", "Conflict", "Enrich",
-				      "Mil_Iso","Mil_Sp","Reactors",
-				      "Sci_Net", "U_Reserve"};
-    int n_factors = sizeof(master_factors) / sizeof(master_factors[0]);
-    
-    if (column_names.size() == 0){
-      for(int f_it = 0; f_it < n_factors; f_it++) {
-	column_names.push_back(master_factors[f_it]);
-      }
-    }
-    
-    // Determine which factors are used in the simulation based on the defined
-    // weights.
-    p_present = DefinedFactors("Pursuit");
-    
-    // Check weights to make sure they add to one, otherwise normalize
-    double tot_weight = 0.0;
-    std::map <std::string, double>::iterator wt_it;
-    for(wt_it = wts.begin(); wt_it != wts.end(); wt_it++) {
-      tot_weight+= wt_it->second;
-    }
-    if (tot_weight == 0){
-      cyclus::Warn<cyclus::VALUE_WARNING>("Weights must be defined!");
-    }
-    else if (tot_weight != 1.0) {
-      for(wt_it = wts.begin(); wt_it != wts.end(); wt_it++) {
-	wt_it->second = wt_it->second/tot_weight;
-      }
-    }
-    
     // If conflict is defined, record initial conflict relations in database
-    int n_states = GetNStates();
     if ((p_present["Conflict"] == true) && n_states > 1){
       std::string eqn_type = "Pursuit";
       std::map<std::pair<std::string, std::string>,int>::iterator it;
@@ -95,23 +103,124 @@ void InteractRegion::Tick() {
   }
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// Determines which factors are defined for this sim
-std::map<std::string, bool>
-  InteractRegion::DefinedFactors(std::string eqn_type) {
+void InteractRegion::Tock() {
+  MBMORE_PERF_TOCK("InteractRegion", context());
+  PublishWeaponStatus_();
+  DecideStates_();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+static bool AgentIdLess(const cyclus::Agent* a, const cyclus::Agent* b) {
+  return a->id() < b->id();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A state's decision depends only on its own factors and RNG stream and on
+// region data (weights, statuses, conflict relations) that is not changed
+// until the decisions are applied, so evaluation order does not matter.
+void InteractRegion::DecideStates_() {
+  std::vector<StateInst*> states;
+  for (std::set<Agent*>::const_iterator inst = children().begin();
+       inst != children().end();
+       inst++) {
+    StateInst* state = dynamic_cast<StateInst*>(*inst);
+    if (state != NULL) {
+      states.push_back(state);
+    }
+  }
+  std::sort(states.begin(), states.end(), AgentIdLess);
+
+  int n_decide = states.size();
+  std::vector<std::string> phases(n_decide);
+  std::vector<StateInst::DecisionResult> results(n_decide);
+  for (int i = 0; i < n_decide; i++) {
+    phases[i] = states[i]->DecisionPhase();
+  }
+
+  int n_workers = decision_threads;
+  if (n_workers <= 0) {
+    n_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  n_workers = std::min(n_workers, n_decide);
+
+  // Each worker takes every n_workers'th state
+  std::function<void(int)> work = [&](int w) {
+    for (int i = w; i < n_decide; i += n_workers) {
+      if (!phases[i].empty()) {
+	states[i]->EvaluateDecision(phases[i], &results[i]);
+      }
+    }
+  };
+  if (n_workers <= 1) {
+    work(0);
+  }
+  else {
+    if (!decision_pool_ || (decision_pool_->size() != n_workers)) {
+      decision_pool_.reset(new WorkerPool(n_workers));
+    }
+    decision_pool_->Run(work);
+  }
+
+  for (int i = 0; i < n_decide; i++) {
+    if (!phases[i].empty()) {
+      states[i]->ApplyDecision(results[i]);
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Determines which factors are defined for this sim, normalizes their
+// weights, and stores both by factor id for the child states
+void InteractRegion::BuildFactorRegistry() {
 
-  std::map<std::string, bool> present;
-  std::map<std::string,double>::iterator factor_it;
-  int n_factors = column_names.size();
-  for(int i = 0; i < n_factors; i++) {
-    factor_it = wts.find(column_names[i]);
-    if (factor_it == wts.end()) {   // factor isn't defined in input file
-      present[column_names[i]]= false;
+  // Define Master List of column names for the database only once.
+  std::string master_factors [kNMasterFactors] = { "Auth", "Conflict",
+						   "Enrich", "Mil_Iso",
+						   "Mil_Sp","Reactors",
+						   "Sci_Net", "U_Reserve"};
+  if (column_names.size() == 0){
+    for(int f_it = 0; f_it < kNMasterFactors; f_it++) {
+      column_names.push_back(master_factors[f_it]);
+    }
+  }
+
+  // Check weights to make sure they add to one, otherwise normalize
+  double tot_weight = 0.0;
+  std::map <std::string, double>::iterator wt_it;
+  for(wt_it = wts.begin(); wt_it != wts.end(); wt_it++) {
+    tot_weight+= wt_it->second;
+  }
+  if (tot_weight == 0){
+    cyclus::Warn<cyclus::VALUE_WARNING>("Weights must be defined!");
+  }
+  else if (tot_weight != 1.0) {
+    for(wt_it = wts.begin(); wt_it != wts.end(); wt_it++) {
+      wt_it->second = wt_it->second/tot_weight;
+    }
+  }
+
+  // Determine which factors are used in the simulation based on the defined
+  // weights.
+  p_present.clear();
+  p_present_ids.reset();
+  p_factor_wts.assign(column_names.size(), 0.0);
+  for(int f = 0; f < column_names.size(); f++) {
+    wt_it = wts.find(column_names[f]);
+    if (wt_it == wts.end()) {   // factor isn't defined in input file
+      p_present[column_names[f]] = false;
     }
     else {
-      present[column_names[i]]= true;
+      p_present[column_names[f]] = true;
+      p_present_ids.set(f);
+      p_factor_wts[f] = wt_it->second;
     }
   }
-  return present;
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Determines which factors are defined for this sim
+const std::map<std::string, bool>&
+  InteractRegion::DefinedFactors(std::string eqn_type) {
+  return p_present;
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Returns a map of regularly used factors and bool to indicate whether they are
@@ -123,13 +232,30 @@ std::vector<std::string>& InteractRegion::GetMasterFactors() {
 // Determine the likelihood value for the equation at the current time,
 // (where the current value of the equation is normalized to be between 0-1)
 double InteractRegion::GetLikely(std::string phase, double eqn_val) {
+  double phase_likely = CalcLikely(phase, eqn_val);
+
+  if ((phase_likely < 0) || (phase_likely > 1)){
+    std::stringstream ss;
+    ss << "likelihood of weapon decision isnt between 0-1!"
+       << "Something went wrong!";
+    cyclus::Warn<cyclus::VALUE_WARNING>(ss.str());
+  }
+  return phase_likely;
+  
+}
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double InteractRegion::CalcLikely(const std::string& phase,
+				  double eqn_val) const {
 
   double hist_duration = 75; // historical data covers 70 years
 
-  std::pair<std::string, std::vector<double> > likely_pair =
-    likely_rescale[phase];
-  std::string function = likely_pair.first;
-  std::vector<double> constants = likely_pair.second;
+  std::map<std::string, std::pair<std::string, std::vector<double> > >
+    ::const_iterator likely_it = likely_rescale.find(phase);
+  if (likely_it == likely_rescale.end()){
+    throw cyclus::ValueError("likely_converter is not defined for " + phase);
+  }
+  const std::string& function = likely_it->second.first;
+  const std::vector<double>& constants = likely_it->second.second;
 
   double phase_likely;
   if (phase == "Pursuit"){
@@ -151,15 +277,7 @@ double InteractRegion::GetLikely(std::string phase, double eqn_val) {
     double avg_time = CalcYVal(function, constants, eqn_val);
     phase_likely = 1.0/avg_time;
   }
-
-  if ((phase_likely < 0) || (phase_likely > 1)){
-    std::stringstream ss;
-    ss << "likelihood of weapon decision isnt between 0-1!"
-       << "Something went wrong!";
-    cyclus::Warn<cyclus::VALUE_WARNING>(ss.str());
-  }
   return phase_likely;
-  
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Determine the Conflict or Military Isolation actor for the state at each
@@ -169,42 +287,23 @@ double InteractRegion::GetLikely(std::string phase, double eqn_val) {
   
 double InteractRegion::GetConflictScore(std::string eqn_type,
 					std::string prototype) {
-  int gross_score = 0;
-  int n_entries = 0;
-
-  std::map<std::pair<std::string, std::string>,int>::iterator map_it;
-  for (map_it = p_conflict_map.begin();
-       map_it != p_conflict_map.end(); ++map_it){
-    std::string curr_state = map_it->first.first;
-    if (curr_state == prototype){
-      n_entries+=1;
-      std::string other_state = map_it->first.second;
-
-      // allies, neutral, or enemies
-      int this_relation = map_it->second;
-      
-      // what is each state's NW status?
-      int my_weapon_status = sim_weapon_status[prototype];
-      int other_weapon_status = sim_weapon_status[other_state];
-      
-      std::string relation_string;
-      // order smallest number first (0_2 instead of 2_0)
-      if (my_weapon_status > other_weapon_status){
-	relation_string = BuildRelationString(other_weapon_status,
-					      my_weapon_status,
-					      this_relation);
-      }
-      else {
-	relation_string = BuildRelationString(my_weapon_status,
-					      other_weapon_status,
-					      this_relation);
-      }
-      gross_score += score_matrix[relation_string];
-    }
+  std::map<std::string, int>::const_iterator id_it = state_ids.find(prototype);
+  if (id_it == state_ids.end()){
+    std::stringstream ss;
+    ss << "State " << prototype
+       << " is not defined in the p_conflict_relations";
+    throw cyclus::ValueError(ss.str());
   }
+  return GetConflictScore(eqn_type, id_it->second);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double InteractRegion::GetConflictScore(std::string eqn_type, int state_id) {
+  MBMORE_PERF_SCOPE("InteractRegion", "GetConflictScore");
+  int n_entries = p_conflict_adj[state_id].size();
   if (n_entries == 0){
     std::stringstream ss;
-    ss << "State " << prototype
+    ss << "State " << state_names[state_id]
        << " is not defined in the p_conflict_relations";
     throw cyclus::ValueError(ss.str());
   }
@@ -212,47 +311,148 @@ double InteractRegion::GetConflictScore(std::string eqn_type,
   // Take all conflict relationships for a single state and average them
   // together to get final conflict score
   // Example: if A-B = 2, A-C = 6, A-D = 10, then total conflict for A = 6
-  double avg_score = static_cast<double>(gross_score)/n_entries;
+  double avg_score = static_cast<double>(p_conflict_sum[state_id])/n_entries;
   return avg_score;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// Make a string that contains the weapons status of states A and state B, as
-// well as their relationship as statusA_statusB_relationship
-// String is used as key for map of conflict scores
+int InteractRegion::RelationCode(int relation) {
+  if (relation == 1){
+    return 2;
+  }
+  else if (relation == 0){
+    return 1;
+  }
+  return 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Status 0 - Non Weapon State, 2 - Pursuing, 3 - Acquired
-std::string InteractRegion::BuildRelationString(int statusA,
-						  int statusB,
-						  int relation){
-
-    std::string relation_string;
-    std::string full_string;
-    if (relation == 1){
-      relation_string = "ally_";
+int InteractRegion::StatusCode(int status) {
+  if ((status != 0) && (status != 2) && (status != 3)){
+    return 0;
+  }
+  return status;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int InteractRegion::StateId(const std::string& proto) {
+  std::pair<std::map<std::string, int>::iterator, bool> ret =
+    state_ids.insert(std::make_pair(proto, int(state_names.size())));
+  if (ret.second){
+    state_names.push_back(proto);
+    sim_weapon_status.push_back(0);
+    next_weapon_status.push_back(0);
+    p_conflict_adj.push_back(std::vector<ConflictEdge>());
+    p_conflict_in.push_back(std::vector<ConflictEdge>());
+    p_conflict_sum.push_back(0);
+  }
+  return ret.first->second;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Start from the default scores and apply any user overrides. Keys are of
+// the form relation_statusA_statusB (eg. "ally_0_2") where relation is ally,
+// neut or enemy and statuses are 0, 2 or 3. An override applies to both
+// orderings of the statuses.
+void InteractRegion::BuildConflictScores() {
+  for (int r = 0; r < 3; r++) {
+    for (int a = 0; a < 4; a++) {
+      for (int b = 0; b < 4; b++) {
+	conflict_scores_[r][a][b] = kConflictScores[r][a][b];
+      }
     }
-    else if (relation == 0){
-      relation_string = "neut_";
+  }
+
+  std::map<std::string, int>::iterator it;
+  for (it = conflict_scores.begin(); it != conflict_scores.end(); ++it) {
+    std::stringstream key(it->first);
+    std::string relation;
+    int status_a = -1;
+    int status_b = -1;
+    char sep = ' ';
+    std::getline(key, relation, '_');
+    key >> status_a >> sep >> status_b;
+    
+    int code = -1;
+    if (relation == "ally") {
+      code = RelationCode(1);
+    } else if (relation == "neut") {
+      code = RelationCode(0);
+    } else if (relation == "enemy") {
+      code = RelationCode(-1);
     }
-    else {
-      relation_string = "enemy_";
+    if ((code < 0) || key.fail() || !key.eof() || (sep != '_') ||
+	(StatusCode(status_a) != status_a) ||
+	(StatusCode(status_b) != status_b)) {
+      std::stringstream ss;
+      ss << "conflict_scores key " << it->first << " is not of the form "
+	 << "ally|neut|enemy_status_status with status 0, 2 or 3";
+      throw cyclus::ValueError(ss.str());
     }
+    conflict_scores_[code][status_a][status_b] = it->second;
+    conflict_scores_[code][status_b][status_a] = it->second;
+  }
 
-    // Any weapons status that is not 0 (never pursued), 2 (pursue), 3 (acquire)
-    // is redefined as never pursued
-    if ((statusA != 0) && (statusA != 2) && (statusA !=3)){
-      statusA = 0;
-    }
-    if ((statusB != 0) && (statusB != 2) && (statusB !=3)){
-      statusB = 0;
+  // Status 1 (exploring, reserved) scores the same as 0
+  for (int r = 0; r < 3; r++) {
+    for (int s = 0; s < 4; s++) {
+      conflict_scores_[r][1][s] = conflict_scores_[r][0][s];
+      conflict_scores_[r][s][1] = conflict_scores_[r][s][0];
     }
-    
-    full_string.append(relation_string);
-    full_string.append(std::to_string(statusA));
-    full_string.append("_");
-    full_string.append(std::to_string(statusB));
+  }
+}
 
-    return full_string;
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Each primary state keeps an adjacency list of its relations so that
+// scoring a state only visits its own pair states.
+void InteractRegion::BuildConflictGraph() {
+  BuildConflictScores();
+  std::map<std::pair<std::string, std::string>,int>::iterator it;
+  for (it = p_conflict_map.begin(); it != p_conflict_map.end(); ++it) {
+    int this_id = StateId(it->first.first);
+    int other_id = StateId(it->first.second);
+    SetConflictEdge_(this_id, other_id, it->second);
   }
+  conflict_graph_built = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Only this_state's running score changes: the relation is this_state's view
+// of other_state.
+void InteractRegion::SetConflictEdge_(int this_id, int other_id,
+				      int relation) {
+  int new_code = RelationCode(relation);
+  int my_status = StatusCode(sim_weapon_status[this_id]);
+  int other_status = StatusCode(sim_weapon_status[other_id]);
+  
+  std::vector<ConflictEdge>& edges = p_conflict_adj[this_id];
+  int e = 0;
+  while ((e < edges.size()) && (edges[e].other != other_id)){
+    e++;
+  }
+  if (e < edges.size()){
+    p_conflict_sum[this_id] -=
+      conflict_scores_[edges[e].relation_code][my_status][other_status];
+    edges[e].relation_code = new_code;
+
+    std::vector<ConflictEdge>& in_edges = p_conflict_in[other_id];
+    for (int i = 0; i < in_edges.size(); i++){
+      if (in_edges[i].other == this_id){
+	in_edges[i].relation_code = new_code;
+      }
+    }
+  }
+  else {
+    ConflictEdge edge;
+    edge.other = other_id;
+    edge.relation_code = new_code;
+    edges.push_back(edge);
+    edge.other = this_id;
+    p_conflict_in[other_id].push_back(edge);
+  }
+  p_conflict_sum[this_id] += conflict_scores_[new_code][my_status][other_status];
+}
   
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Change the Conflict value for a state. If the simulation is symmetric,
@@ -263,12 +463,16 @@ void InteractRegion::ChangeConflictReln(std::string eqn_type,
 					  std::string this_state,
 					  std::string other_state, int new_val){
 
+  int this_id = StateId(this_state);
+  int other_id = StateId(other_state);
   p_conflict_map[std::pair<std::string, std::string>
 		 (this_state, other_state)] = new_val;
+  SetConflictEdge_(this_id, other_id, new_val);
   RecordConflictReln(eqn_type, this_state, other_state, new_val);
   if (symmetric == 1){
     p_conflict_map[std::pair<std::string, std::string>
 		   (other_state, this_state)] = new_val;
+    SetConflictEdge_(other_id, this_id, new_val);
     RecordConflictReln(eqn_type, other_state, this_state, new_val);
   }
 }
@@ -279,13 +483,59 @@ void InteractRegion::ChangeConflictReln(std::string eqn_type,
 // (Reserved but not implemented: -1 = gave up weapons program, 1 = exploring)
 void InteractRegion::UpdateWeaponStatus(std::string proto,
 					int new_weapon_status){
+  UpdateWeaponStatus(StateId(proto), new_weapon_status);
+}
 
-  // add new key value pair. If key already exists then just update value
-  std::pair<std::map<std::string, int>::iterator, bool> ret;
-  ret = sim_weapon_status.insert(std::pair<std::string, int>
-				 (proto, new_weapon_status));
-  if (ret.second ==false){
-    sim_weapon_status[proto] = new_weapon_status;
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::UpdateWeaponStatus(int state_id, int new_weapon_status){
+  if (next_weapon_status[state_id] == sim_weapon_status[state_id]){
+    status_dirty.push_back(state_id);
+  }
+  next_weapon_status[state_id] = new_weapon_status;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Only states whose status changed are visited (a state changed back to its
+// visible status within a timestep may be listed, and is a no-op)
+void InteractRegion::PublishWeaponStatus_() {
+  for (int i = 0; i < status_dirty.size(); i++){
+    int state_id = status_dirty[i];
+    ApplyWeaponStatus_(state_id, next_weapon_status[state_id]);
+  }
+  status_dirty.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegion::ApplyWeaponStatus_(int state_id, int new_weapon_status){
+  int old_status = StatusCode(sim_weapon_status[state_id]);
+  int new_status = StatusCode(new_weapon_status);
+  sim_weapon_status[state_id] = new_weapon_status;
+  next_weapon_status[state_id] = new_weapon_status;
+  if (old_status == new_status){
+    return;
+  }
+
+  // Rescore this state's own relations
+  const std::vector<ConflictEdge>& edges = p_conflict_adj[state_id];
+  int my_sum = 0;
+  for (int e = 0; e < edges.size(); e++){
+    int other_status = StatusCode(sim_weapon_status[edges[e].other]);
+    my_sum += conflict_scores_[edges[e].relation_code][new_status][other_status];
+  }
+  p_conflict_sum[state_id] = my_sum;
+
+  // Adjust the score of every state that holds a relation to this one
+  const std::vector<ConflictEdge>& in_edges = p_conflict_in[state_id];
+  for (int i = 0; i < in_edges.size(); i++){
+    int primary = in_edges[i].other;
+    if (primary == state_id){
+      continue;
+    }
+    int code = in_edges[i].relation_code;
+    int primary_status = StatusCode(sim_weapon_status[primary]);
+    p_conflict_sum[primary] +=
+      conflict_scores_[code][primary_status][new_status] -
+      conflict_scores_[code][primary_status][old_status];
   }
 }
 
@@ -305,34 +555,6 @@ void InteractRegion::RecordConflictReln(std::string eqn_type,
   d->AddVal("Conflict", new_val);
   d->Record();
 }
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// Build Score Matrix
-  void InteractRegion::BuildScoreMatrix(){
-    score_matrix.insert(std::pair<std::string, int>("ally_0_0", 2));
-    score_matrix.insert(std::pair<std::string, int>("neut_0_0", 2));
-    score_matrix.insert(std::pair<std::string, int>("enemy_0_0", 6));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_0_2", 3));
-    score_matrix.insert(std::pair<std::string, int>("neut_0_2", 4));
-    score_matrix.insert(std::pair<std::string, int>("enemy_0_2", 8));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_0_3", 1));
-    score_matrix.insert(std::pair<std::string, int>("neut_0_3", 4));
-    score_matrix.insert(std::pair<std::string, int>("enemy_0_3", 6));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_2_2", 3));
-    score_matrix.insert(std::pair<std::string, int>("neut_2_2", 4));
-    score_matrix.insert(std::pair<std::string, int>("enemy_2_2", 9));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_2_3", 3));
-    score_matrix.insert(std::pair<std::string, int>("neut_2_3", 5));
-    score_matrix.insert(std::pair<std::string, int>("enemy_2_3", 10));
-    
-    score_matrix.insert(std::pair<std::string, int>("ally_3_3", 1));
-    score_matrix.insert(std::pair<std::string, int>("neut_3_3", 3));
-    score_matrix.insert(std::pair<std::string, int>("enemy_3_3", 5));
-  }
-  
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   std::string InteractRegion::str() {
   std::string s = cyclus::Agent::str();
@@ -1,10 +1,41 @@
 #ifndef MBMORE_SRC_INTERACT_REGION_H_
 #define MBMORE_SRC_INTERACT_REGION_H_
 
+#include <bitset>
+#include <memory>
+
 #include "cyclus.h"
+#include "worker_pool.h"
 
 namespace mbmore {
 
+// Number of factors in the master list (see InteractRegion::column_names)
+const int kNMasterFactors = 8;
+
+// One bit per master factor, indexed by factor id
+typedef std::bitset<kNMasterFactors> FactorSet;
+
+// Conflict score for a pair of states, indexed by
+// [relation code][status of state A][status of state B].
+// Relation codes: 0 = enemies (-1), 1 = neutral (0), 2 = allies (+1)
+// Status: 0 = not pursuing, 2 = pursuing, 3 = acquired. Status 1 (exploring,
+// reserved) scores the same as 0. The table is symmetric in the two statuses.
+constexpr int kConflictScores[3][4][4] = {
+  // enemies
+  {{6, 6, 8, 6}, {6, 6, 8, 6}, {8, 8, 9, 10}, {6, 6, 10, 5}},
+  // neutral
+  {{2, 2, 4, 4}, {2, 2, 4, 4}, {4, 4, 4, 5}, {4, 4, 5, 3}},
+  // allies
+  {{2, 2, 3, 1}, {2, 2, 3, 1}, {3, 3, 3, 3}, {1, 1, 3, 1}}
+};
+
+// Relationship between a primary state and one of its pair states in the
+// conflict graph
+struct ConflictEdge {
+  int other;           // state id of the pair state
+  int relation_code;   // row of the conflict score table
+};
+
 /// @class Region
 ///
 /// The Region class is the abstract class/interface used by all
@@ -14,7 +45,7 @@ namespace mbmore {
 
 class InteractRegion
   : public cyclus::Region {
-  friend class InteractRegionTests;
+  friend class InteractRegionTest;
  public:
   /// Default constructor for InteractRegion Class
   InteractRegion(cyclus::Context* ctx);
@@ -31,7 +62,8 @@ class InteractRegion
 
   virtual void Tick();
 
-  virtual void Tock() {}
+  // Makes the weapon decisions for all child states (see DecideStates_)
+  virtual void Tock();
 
   // perform actions required when entering the simulation
   virtual void Build(cyclus::Agent* parent);
@@ -41,38 +73,69 @@ class InteractRegion
 
   // shares the pursuit and acquisition equation weighting information
   // with the child institutions
-  std::map<std::string, double> GetWeights(std::string eqn_type);
+  const std::map<std::string, double>& GetWeights(std::string eqn_type);
+
+  // Normalized weight of each master factor, indexed by factor id (zero for
+  // factors that are not defined). Computed once at the start of the sim.
+  const std::vector<double>& GetFactorWeights(std::string eqn_type);
+
+  // Which master factors are defined in this sim, indexed by factor id
+  const FactorSet& GetPresentFactors(std::string eqn_type);
+
+  // Position of a factor in the master list, or -1 if it is not a master
+  // factor
+  int FactorId(const std::string& factor);
 
   // Determines # of states in the simulation. If only one state then
   // Interactive Factors (such as conflict) are not calculated.
+  // (Counted once per timestep in the Tick)
   int GetNStates();
   
   // Uses the pursuit or acquire likelihood conversion equation to determine the
   // likeliness of pursuit and acquire on a 0-1 scale for the requested timestep
   double GetLikely(std::string phase, double eqn_val);
 
+  // Same as GetLikely, without warning about a likelihood outside 0-1. Does
+  // not modify the region, so it is safe to call from concurrent decisions.
+  double CalcLikely(const std::string& phase, double eqn_val) const;
 
-  // Determines which factors are defined for this sim
-  std::map<std::string, bool> DefinedFactors(std::string eqn_type);
 
   // Returns a map of regularly used factors and bool to indicate whether
-  // the are defined in this sim.
-  std::map<std::string, bool> GetDefinedFactors(std::string eqn_type);
+  // they are defined in this sim.
+  const std::map<std::string, bool>& DefinedFactors(std::string eqn_type);
 
   // Returns the master list of all factors to be recorded in database
   std::vector<std::string>& GetMasterFactors();
 
+  // Whether states record weapon progress as factor changes only (see
+  // sparse_progress)
+  bool SparseProgress() const { return sparse_progress; }
+
   // Tracks weapons status of each state (0 = not pursuing, 2 = pursuing,
-  // 3 = acquired) by updating the sim_weapon_status map
+  // 3 = acquired). The new status is written to next_weapon_status and is
+  // not seen by any state (or conflict score) until the region's next Tock.
   virtual void UpdateWeaponStatus(std::string proto, int new_weapon_status);
+  void UpdateWeaponStatus(int state_id, int new_weapon_status);
+
+  // Status of a state as of the start of the current timestep's decisions
+  int GetWeaponStatus(int state_id) const { return sim_weapon_status[state_id]; }
+
+  // Returns the integer id of a state (by prototype name), assigning a new
+  // id the first time a state is seen
+  int StateId(const std::string& proto);
 
   // Determines Conflict score for each state based on its net
-  // relationships with other states and both states' weapon status
+  // relationships with other states and both states' weapon status.
+  // Scores are kept up to date as statuses and relations change.
   double GetConflictScore(std::string eqn_type, std::string prototype);
+  double GetConflictScore(std::string eqn_type, int state_id);
+
+  // Row of the conflict score table for a relation (+1 ally, 0 neutral, other enemy)
+  static int RelationCode(int relation);
 
-  // Builds a string to use as key for map that defines the conflict score
-  // for a pair states based on their ally/neutral/enemy relationship
-  std::string BuildRelationString(int statusA, int statusB, int relation);
+  // Column of the conflict score table for a weapon status. Any status that is not
+  // 0 (never pursued), 2 (pursue), 3 (acquire) is treated as never pursued
+  static int StatusCode(int status);
 
   // Changes conflict relationship from initial value to final value at the
   // specified time
@@ -87,9 +150,17 @@ class InteractRegion
 				    std::string other_state, int new_val);
 
 
-  // Initialize the map that defines how state relationships map to conflict
-  // score
-  virtual void BuildScoreMatrix();
+  // Build the per-state adjacency lists of the conflict graph from
+  // p_conflict_map
+  void BuildConflictGraph();
+
+  // Fill the active conflict score table from kConflictScores and any
+  // conflict_scores overrides
+  void BuildConflictScores();
+
+  // Compute the factor registry (column ids, normalized weights and which
+  // factors are present) that is shared read-only with the child states
+  void BuildFactorRegistry();
 
   /// every agent should be able to print a verbose description
   virtual std::string str();
@@ -133,6 +204,41 @@ bool symmetric;
     }
   std::map<std::pair<std::string,std::string>, int> p_conflict_map ;
 
+#pragma cyclus var {							\
+    "default": {},							\
+    "alias": ["conflict_scores", "relation", "score"],			\
+    "doc": "Optional overrides of the default conflict score for a pair " \
+           "of states. Keys are relation_statusA_statusB, where relation " \
+           "is ally, neut or enemy and status is 0 (not pursuing), " \
+           "2 (pursuing) or 3 (acquired), eg. enemy_2_3. Scores are on a " \
+           "0-10 scale (0 == alliance, 10 == conflict)",		\
+    }
+  std::map<std::string, int> conflict_scores ;
+
+
+#pragma cyclus var {							\
+    "default": 1,							\
+    "tooltip": "Threads used to evaluate state weapon decisions",	\
+    "doc": "Number of threads used to evaluate the weapon decisions of the " \
+           "child states each timestep. 1 (the default) evaluates the " \
+           "states serially, which is fastest for a few states; 0 uses " \
+           "one thread per available core. Results do not depend on the " \
+           "number of threads.",					\
+    }
+  int decision_threads;
+
+#pragma cyclus var {							\
+    "default": 0,							\
+    "tooltip": "Record only changes in state pursuit factors",		\
+    "doc": "If False, each state writes every master factor to the "	\
+           "WeaponProgress table at every timestep (zero for factors not " \
+           "defined in the sim). If True, WeaponProgress holds only the " \
+           "equation value, likelihood and decision; factor values are " \
+           "written to WeaponFactorChanges only when they differ from the " \
+           "state's previous value, and the undefined factors are listed " \
+           "once per state in UndefinedFactors.",			\
+    }
+  bool sparse_progress;
 
 // Defines persistent column names in WeaponProgress table of database
 // Must be defined globally so that references to the column name 
@@ -143,12 +249,61 @@ static std::vector<std::string> column_names;
 std::map<std::string, bool> p_present;
 std::map<std::string, bool> a_present;
 
-// Tracks the weapons status of each state
-std::map<std::string, int> sim_weapon_status;
-
-// Defines conflict scores given weapon status of 2 states and their
-// relationship (ally, neut, enemy)
-std::map<std::string, int> score_matrix;
+// Factor registry, indexed by factor id (position in column_names)
+std::vector<double> p_factor_wts;
+FactorSet p_present_ids;
+
+// Number of StateInst children, counted at each Tick
+int n_states;
+
+// Interned state prototypes, so that state relationships and statuses can
+// be stored in vectors indexed by state id
+std::map<std::string, int> state_ids;
+std::vector<std::string> state_names;
+
+// Tracks the weapons status of each state, indexed by state id. Decisions
+// read sim_weapon_status while status updates are written to
+// next_weapon_status, and the states listed in status_dirty are copied over
+// at the start of the region's Tock.
+std::vector<int> sim_weapon_status;
+std::vector<int> next_weapon_status;
+std::vector<int> status_dirty;
+
+// Conflict graph: the relations of each primary state to its pair states,
+// indexed by the primary state's id
+std::vector<std::vector<ConflictEdge> > p_conflict_adj;
+bool conflict_graph_built;
+
+// Active conflict scores, indexed like kConflictScores
+int conflict_scores_[3][4][4];
+
+// Reverse of p_conflict_adj: for each state, the primary states that hold a
+// relation to it (other = primary state id, relation_code of that relation)
+std::vector<std::vector<ConflictEdge> > p_conflict_in;
+
+// Running sum of conflict_scores_ over each state's relations. Maintained on
+// status and relation changes so that GetConflictScore is O(1).
+std::vector<int> p_conflict_sum;
+
+// Make the status updates from the previous timestep visible to decisions
+// and conflict scores
+void PublishWeaponStatus_();
+
+// Set the visible status of one state and update the conflict scores that
+// depend on it
+void ApplyWeaponStatus_(int state_id, int new_weapon_status);
+
+// Evaluate the weapon decision of every child StateInst (on decision_threads
+// threads) against the statuses at the start of the timestep, then record and
+// apply them serially in agent id order
+void DecideStates_();
+
+// Threads that evaluate the decisions when decision_threads > 1, started at
+// the first decision and kept for the rest of the sim
+std::unique_ptr<WorkerPool> decision_pool_;
+
+// Add or update the relation from this_state to other_state in the graph
+void SetConflictEdge_(int this_id, int other_id, int relation);
 
   
  
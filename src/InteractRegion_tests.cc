@@ -1,5 +1,9 @@
+#include "InteractRegion_tests.h"
+
 #include <gtest/gtest.h>
 
+#include <chrono>
+
 #include "cyclus.h"
 
 
@@ -9,6 +13,308 @@
 
 namespace mbmore {
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::SetUp() {
+  region = new InteractRegion(tc_.get());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::TearDown() { delete region; }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::SetWeight(std::string factor, double weight) {
+  region->wts[factor] = weight;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::DoTick() { region->Tick(); }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::PublishStatus() { region->PublishWeaponStatus_(); }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::SetSymmetric(bool symmetric) {
+  region->symmetric = symmetric;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::SetRelation(std::string this_state,
+                                     std::string other_state, int relation) {
+  region->p_conflict_map[std::make_pair(this_state, other_state)] = relation;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double InteractRegionTest::RecomputeConflictScore(std::string state) {
+  int id = region->state_ids.at(state);
+  const std::vector<ConflictEdge>& edges = region->p_conflict_adj[id];
+  int my_status = InteractRegion::StatusCode(region->sim_weapon_status[id]);
+  int sum = 0;
+  for (int e = 0; e < edges.size(); e++) {
+    int other_status =
+      InteractRegion::StatusCode(region->sim_weapon_status[edges[e].other]);
+    sum += region->conflict_scores_[edges[e].relation_code][my_status]
+      [other_status];
+  }
+  return static_cast<double>(sum) / edges.size();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InteractRegionTest::SetConflictScore(std::string key, int score) {
+  region->conflict_scores[key] = score;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int InteractRegionTest::ConflictScore(int relation, int status_a,
+                                      int status_b) {
+  return region->conflict_scores_[InteractRegion::RelationCode(relation)]
+    [status_a][status_b];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::map<std::string, double> InteractRegionTest::CopyWeights() {
+  return region->wts;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::map<std::string, bool> InteractRegionTest::RebuildDefinedFactors() {
+  std::map<std::string, bool> present;
+  std::vector<std::string>& master_factors = region->GetMasterFactors();
+  for (int f = 0; f < master_factors.size(); f++) {
+    present[master_factors[f]] =
+      (region->wts.find(master_factors[f]) != region->wts.end());
+  }
+  return present;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Registry is computed once at t=0: weights are normalized and indexed by
+// factor id, and only defined factors are flagged as present.
+TEST_F(InteractRegionTest, FactorRegistry) {
+  SetWeight("Enrich", 1.0);
+  SetWeight("Conflict", 3.0);
+  DoTick();
+
+  int enrich_id = region->FactorId("Enrich");
+  int conflict_id = region->FactorId("Conflict");
+  int auth_id = region->FactorId("Auth");
+  ASSERT_GE(enrich_id, 0);
+  ASSERT_GE(conflict_id, 0);
+  ASSERT_GE(auth_id, 0);
+  EXPECT_EQ(-1, region->FactorId("Dem"));
+
+  const std::vector<double>& wts = region->GetFactorWeights("Pursuit");
+  const FactorSet& present = region->GetPresentFactors("Pursuit");
+  EXPECT_EQ(kNMasterFactors, static_cast<int>(wts.size()));
+  EXPECT_DOUBLE_EQ(0.25, wts[enrich_id]);
+  EXPECT_DOUBLE_EQ(0.75, wts[conflict_id]);
+  EXPECT_DOUBLE_EQ(0.0, wts[auth_id]);
+  EXPECT_EQ(2, static_cast<int>(present.count()));
+  EXPECT_TRUE(present[conflict_id]);
+  EXPECT_FALSE(present[auth_id]);
+  EXPECT_TRUE(region->DefinedFactors("Pursuit").at("Enrich"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Conflict score averages the score table over a state's own relations and
+// follows both weapon-status and relation changes.
+TEST_F(InteractRegionTest, ConflictScore) {
+  SetSymmetric(true);
+  SetRelation("A", "B", 1);
+  SetRelation("A", "C", -1);
+  SetRelation("B", "A", 1);
+  SetRelation("C", "A", -1);
+  region->BuildConflictGraph();
+
+  // allies (2) and enemies (6) with nobody pursuing
+  EXPECT_DOUBLE_EQ(4.0, region->GetConflictScore("Pursuit", "A"));
+  EXPECT_DOUBLE_EQ(2.0, region->GetConflictScore("Pursuit", "B"));
+
+  // A pursues and C acquires: allies A-B (3), enemies A-C (10)
+  region->UpdateWeaponStatus("A", 2);
+  region->UpdateWeaponStatus("C", 3);
+  PublishStatus();
+  EXPECT_DOUBLE_EQ(6.5, region->GetConflictScore("Pursuit", "A"));
+  EXPECT_DOUBLE_EQ(10.0, region->GetConflictScore("Pursuit", "C"));
+
+  // A and C become neutral (5) in both directions
+  region->ChangeConflictReln("Pursuit", "A", "C", 0);
+  EXPECT_DOUBLE_EQ(4.0, region->GetConflictScore("Pursuit", "A"));
+  EXPECT_DOUBLE_EQ(5.0, region->GetConflictScore("Pursuit", "C"));
+
+  EXPECT_THROW(region->GetConflictScore("Pursuit", "D"), cyclus::ValueError);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Status updates made during a timestep are not seen by any state until
+// they are published at the next region Tock, whatever the update order.
+TEST_F(InteractRegionTest, DoubleBufferedStatus) {
+  SetRelation("A", "B", -1);
+  SetRelation("B", "A", -1);
+  region->BuildConflictGraph();
+  int a = region->StateId("A");
+  int b = region->StateId("B");
+
+  region->UpdateWeaponStatus(a, 2);
+  EXPECT_EQ(0, region->GetWeaponStatus(a));
+  EXPECT_DOUBLE_EQ(6.0, region->GetConflictScore("Pursuit", b));
+  region->UpdateWeaponStatus(b, 3);
+  EXPECT_DOUBLE_EQ(6.0, region->GetConflictScore("Pursuit", a));
+
+  PublishStatus();
+  EXPECT_EQ(2, region->GetWeaponStatus(a));
+  EXPECT_EQ(3, region->GetWeaponStatus(b));
+  EXPECT_DOUBLE_EQ(10.0, region->GetConflictScore("Pursuit", a));
+  EXPECT_DOUBLE_EQ(10.0, region->GetConflictScore("Pursuit", b));
+
+  // changed and changed back within a timestep
+  region->UpdateWeaponStatus(a, 3);
+  region->UpdateWeaponStatus(a, 2);
+  region->UpdateWeaponStatus(a, 3);
+  region->UpdateWeaponStatus(a, 2);
+  PublishStatus();
+  EXPECT_EQ(2, region->GetWeaponStatus(a));
+  EXPECT_DOUBLE_EQ(10.0, region->GetConflictScore("Pursuit", a));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Default table reproduces the original 18 string-keyed scores, in either
+// status order.
+TEST_F(InteractRegionTest, DefaultConflictScores) {
+  region->BuildConflictScores();
+  int statuses[6][2] = {{0, 0}, {0, 2}, {0, 3}, {2, 2}, {2, 3}, {3, 3}};
+  int ally[6] = {2, 3, 1, 3, 3, 1};
+  int neut[6] = {2, 4, 4, 4, 5, 3};
+  int enemy[6] = {6, 8, 6, 9, 10, 5};
+  for (int i = 0; i < 6; i++) {
+    int a = statuses[i][0];
+    int b = statuses[i][1];
+    EXPECT_EQ(ally[i], ConflictScore(1, a, b));
+    EXPECT_EQ(ally[i], ConflictScore(1, b, a));
+    EXPECT_EQ(neut[i], ConflictScore(0, a, b));
+    EXPECT_EQ(neut[i], ConflictScore(0, b, a));
+    EXPECT_EQ(enemy[i], ConflictScore(-1, a, b));
+    EXPECT_EQ(enemy[i], ConflictScore(-1, b, a));
+  }
+  // exploring (1) scores as not pursuing
+  EXPECT_EQ(8, ConflictScore(-1, 1, 2));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(InteractRegionTest, ConflictScoreOverrides) {
+  SetConflictScore("enemy_3_2", 7);
+  SetConflictScore("ally_0_0", 0);
+  region->BuildConflictScores();
+  EXPECT_EQ(7, ConflictScore(-1, 2, 3));
+  EXPECT_EQ(7, ConflictScore(-1, 3, 2));
+  EXPECT_EQ(0, ConflictScore(1, 0, 0));
+  EXPECT_EQ(0, ConflictScore(1, 1, 0));
+  EXPECT_EQ(9, ConflictScore(-1, 2, 2));
+
+  SetConflictScore("rival_0_2", 4);
+  EXPECT_THROW(region->BuildConflictScores(), cyclus::ValueError);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Running conflict sums stay equal to a full recompute through a sequence
+// of asymmetric relation and status changes.
+TEST_F(InteractRegionTest, IncrementalConflictScore) {
+  std::string states[] = {"A", "B", "C", "D"};
+  int n = 4;
+  SetSymmetric(false);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      if (i != j) {
+        SetRelation(states[i], states[j], (i + j) % 3 - 1);
+      }
+    }
+  }
+  region->BuildConflictGraph();
+
+  int statuses[] = {2, 3, 0, 2, 1, 3};
+  for (int step = 0; step < 12; step++) {
+    region->UpdateWeaponStatus(states[step % n], statuses[step % 6]);
+    region->UpdateWeaponStatus(states[(step + 3) % n], statuses[step % 5]);
+    PublishStatus();
+    region->ChangeConflictReln("Pursuit", states[(step + 1) % n],
+                               states[(step + 2) % n], step % 3 - 1);
+    for (int i = 0; i < n; i++) {
+      EXPECT_DOUBLE_EQ(RecomputeConflictScore(states[i]),
+                       region->GetConflictScore("Pursuit", states[i]))
+        << "state " << states[i] << " at step " << step;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The registry holds the same weights and defined factors as the region's
+// maps by factor name, which is what the states used to copy every query
+TEST_F(InteractRegionTest, FactorRegistryMatchesMaps) {
+  SetWeight("Auth", 0.15);
+  SetWeight("Conflict", 0.15);
+  SetWeight("Enrich", 0.16);
+  SetWeight("Mil_Iso", 0.10);
+  SetWeight("Mil_Sp", 0.15);
+  SetWeight("Reactors", 0.10);
+  SetWeight("Sci_Net", 0.10);
+  DoTick();
+
+  std::vector<std::string>& master_factors = region->GetMasterFactors();
+  std::map<std::string, double> P_wt = CopyWeights();
+  std::map<std::string, bool> present = RebuildDefinedFactors();
+  const std::vector<double>& registry_wt = region->GetFactorWeights("Pursuit");
+  const FactorSet& registry_present = region->GetPresentFactors("Pursuit");
+  ASSERT_EQ(master_factors.size(), registry_wt.size());
+  for (int f = 0; f < master_factors.size(); f++) {
+    const std::string& factor = master_factors[f];
+    EXPECT_EQ(present[factor], registry_present[f]) << factor;
+    if (present[factor]) {
+      EXPECT_DOUBLE_EQ(P_wt[factor], registry_wt[f]) << factor;
+    }
+    else {
+      EXPECT_EQ(0, registry_wt[f]) << factor;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Benchmark (run with --gtest_also_run_disabled_tests) of the registry
+// queries every StateInst makes each timestep. The time per timestep is
+// reported as a test property.
+TEST_F(InteractRegionTest, DISABLED_FactorRegistryOverhead) {
+  int n_states = 250;
+  int n_timesteps = 100;
+
+  SetWeight("Auth", 0.15);
+  SetWeight("Conflict", 0.15);
+  SetWeight("Enrich", 0.16);
+  SetWeight("Mil_Iso", 0.10);
+  SetWeight("Mil_Sp", 0.15);
+  SetWeight("Reactors", 0.10);
+  SetWeight("Sci_Net", 0.10);
+  SetWeight("U_Reserve", 0.09);
+  DoTick();
+
+  typedef std::chrono::steady_clock clock;
+  double registry_sum = 0;
+  clock::time_point start = clock::now();
+  for (int t = 0; t < n_timesteps; t++) {
+    for (int s = 0; s < n_states; s++) {
+      const std::vector<double>& P_wt = region->GetFactorWeights("Pursuit");
+      const FactorSet& present = region->GetPresentFactors("Pursuit");
+      for (int f = 0; f < P_wt.size(); f++) {
+	if (present[f]) {
+	  registry_sum += P_wt[f];
+	}
+      }
+    }
+  }
+  double registry_ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count() / n_timesteps;
+
+  RecordProperty("registry_ns_per_timestep", int(registry_ns));
+  EXPECT_NEAR(n_timesteps * n_states, registry_sum, 1e-6 * registry_sum);
+}
+
 
 namespace InteractRegionTests {
   /*
@@ -0,0 +1,41 @@
+#ifndef MBMORE_SRC_INTERACTREGION_TESTS_
+#define MBMORE_SRC_INTERACTREGION_TESTS_
+
+#include <gtest/gtest.h>
+
+#include "test_context.h"
+
+#include "InteractRegion.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+class InteractRegionTest : public ::testing::Test {
+ protected:
+  cyclus::TestContext tc_;
+  InteractRegion* region;
+
+  virtual void SetUp();
+  virtual void TearDown();
+  /// @param factor master factor to give a pursuit weight to
+  void SetWeight(std::string factor, double weight);
+  void DoTick();
+  /// Publish pending weapon status updates, as at the start of region Tock
+  void PublishStatus();
+  void SetSymmetric(bool symmetric);
+  /// @param relation 1 = allies, 0 = neutral, -1 = enemies
+  void SetRelation(std::string this_state, std::string other_state,
+                   int relation);
+  void SetConflictScore(std::string key, int score);
+  /// Entry of the active conflict score table
+  int ConflictScore(int relation, int status_a, int status_b);
+  /// Conflict score summed from scratch over the state's relations
+  double RecomputeConflictScore(std::string state);
+  /// The region's weights and defined factors as maps by factor name, to
+  /// check the factor registry against
+  std::map<std::string, double> CopyWeights();
+  std::map<std::string, bool> RebuildDefinedFactors();
+};
+
+}  // namespace mbmore
+#endif  // MBMORE_SRC_INTERACTREGION_TESTS_
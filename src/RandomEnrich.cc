@@ -2,6 +2,8 @@
 #include "RandomEnrich.h"
 #include "behavior_functions.h"
 #include "enrich_functions.h"
+#include "mbmore_log.h"
+#include "perf_timers.h"
 #include "sim_init.h"
 
 #include <algorithm>
@@ -17,12 +19,19 @@ namespace mbmore {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 RandomEnrich::RandomEnrich(cyclus::Context* ctx)
     : cyclus::Facility(ctx),
+      net_heu(0),
+      HEU_present(false),
+      contam_signature(0),
+      contam_time(0),
       tails_assay(0),
       sigma_tails(0),
       social_behav("None"), 
       behav_interval(0),
       heu_ship_qty(0),
       inspect_freq(0),
+      contam_scale(0),
+      contam_half_life(0),
+      sample_locations(1, "Cascade"),
       n_swipes(10),
       false_pos(0),
       false_neg(0),
@@ -34,7 +43,13 @@ RandomEnrich::RandomEnrich(cyclus::Context* ctx)
       feed_recipe(""),
       product_commod(""),
       tails_commod(""),
-      order_prefs(true){}
+      order_prefs(true),
+      behavior_(kNoBehavior),
+      schedule_start_(0),
+      converter_tails_(-1),
+      converter_feed_(-1),
+      next_inspect_(0),
+      schedules_built_(false) {}
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 RandomEnrich::~RandomEnrich() {}
@@ -58,6 +73,27 @@ void RandomEnrich::Build(cyclus::Agent* parent) {
   using cyclus::Material;
 
   Facility::Build(parent);
+  if (ParseSocialBehavior(social_behav) == kUnknownBehavior) {
+    throw cyclus::ValueError("RandomEnrich social_behav must be None, Every, "
+			     "Random or Reference, not " + social_behav);
+  }
+
+  if (!location_detect.empty() &&
+      (location_detect.size() != sample_locations.size())) {
+    throw cyclus::ValueError("location_detect must have one probability "
+			     "for each of the sample_locations");
+  }
+  for (int loc = 0; loc < location_detect.size(); loc++) {
+    if ((location_detect[loc] < 0) || (location_detect[loc] > 1)) {
+      throw cyclus::ValueError("location_detect must be between 0 and 1");
+    }
+  }
+  if (!tails_bounds.empty() &&
+      ((tails_bounds.size() != 2) || (tails_bounds[0] > tails_bounds[1]))) {
+    throw cyclus::ValueError("tails_bounds must be a lower and an upper "
+			     "limit on the tails assay");
+  }
+  BuildSchedules_();
   if (initial_feed > 0) {
     inventory.Push(
       Material::Create(
@@ -71,6 +107,7 @@ void RandomEnrich::Build(cyclus::Agent* parent) {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::Tick() {
+  MBMORE_PERF_TICK("RandomEnrich", context());
 
   int cur_time = context()->time();
 
@@ -80,27 +117,19 @@ void RandomEnrich::Tick() {
     HEU_present = 0;
   }
 
-  // decide whether trading if trading only sometimes.
-  trade_timestep = 0 ;
-  if (social_behav == "Every" && behav_interval > 0) {
-    trade_timestep = (EveryXTimestep(cur_time, behav_interval));
-  }
-  else if (social_behav == "Random" && behav_interval > 0) {
-    trade_timestep = (EveryRandomXTimestep(behav_interval, rng_seed));
-  }
-  else if (social_behav == "None") {
-    trade_timestep = 1;
+  // A restart from a snapshot does not call Build, so the schedules are
+  // drawn here instead
+  if (!schedules_built_) {
+    BuildSchedules_();
   }
+
+  // decide whether trading if trading only sometimes (drawn at Build).
+  int step = cur_time - schedule_start_;
+  trade_timestep = (step >= 0) && (step < trade_schedule_.size()) &&
+    trade_schedule_[step];
   
   // determine tails assay for the timestep if it is variable
-  curr_tails_assay = RNG_NormalDist(tails_assay, sigma_tails,
-				    rng_seed);
-  if (curr_tails_assay < (tails_assay - sigma_tails)) {
-    curr_tails_assay = tails_assay - sigma_tails;
-  }
-  if (curr_tails_assay > (tails_assay + sigma_tails)) {
-    curr_tails_assay = tails_assay + sigma_tails;
-  }
+  UpdateTailsAssay_(cur_time);
 
   LOG(cyclus::LEV_INFO3, "EnrFac") << prototype() << " is ticking {";
   LOG(cyclus::LEV_INFO3, "EnrFac") << "}";
@@ -109,12 +138,20 @@ void RandomEnrich::Tick() {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::Tock() {
+  MBMORE_PERF_TOCK("RandomEnrich", context());
   using cyclus::toolkit::RecordTimeSeries;
   RecordTimeSeries<cyclus::toolkit::ENRICH_SWU>(this, intra_timestep_swu_);
   RecordTimeSeries<cyclus::toolkit::ENRICH_FEED>(this, intra_timestep_feed_);
 
-  // Add any inspections to the Inspection table
-  bool do_inspect = EveryRandomXTimestep(inspect_freq, rng_seed);
+  // Add any inspections to the Inspection table. Inspection times are
+  // drawn at Build, so a timestep without an inspection does not use the RNG.
+  int cur_time = context()->time();
+  bool do_inspect = false;
+  while ((next_inspect_ < inspect_times_.size()) &&
+	 (inspect_times_[next_inspect_] <= cur_time)) {
+    do_inspect = true;
+    next_inspect_++;
+  }
   if (do_inspect == true){
     RecordInspection_();
   }
@@ -124,6 +161,7 @@ void RandomEnrich::Tock() {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
     RandomEnrich::GetMatlRequests() {
+  MBMORE_PERF_SCOPE("RandomEnrich", "GetMatlRequests");
   using cyclus::Material;
   using cyclus::RequestPortfolio;
   using cyclus::Request;
@@ -145,6 +183,7 @@ std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
 //  U-235 content
 void RandomEnrich::AdjustMatlPrefs(
     cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_PERF_SCOPE("RandomEnrich", "AdjustMatlPrefs");
 
   using cyclus::Bid;
   using cyclus::Material;
@@ -205,6 +244,7 @@ void RandomEnrich::AcceptMatlTrades(
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> RandomEnrich::GetMatlBids(
     cyclus::CommodMap<cyclus::Material>::type& out_requests){
+  MBMORE_PERF_SCOPE("RandomEnrich", "GetMatlBids");
   using cyclus::Bid;
   using cyclus::BidPortfolio;
   using cyclus::CapacityConstraint;
@@ -262,10 +302,9 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> RandomEnrich::GetMatlBids(
       }
     }
     */
-    Converter<Material>::Ptr sc(new SWUConverter(FeedAssay(), curr_tails_assay));
-    Converter<Material>::Ptr nc(new NatUConverter(FeedAssay(), curr_tails_assay));
-    CapacityConstraint<Material> swu(swu_capacity, sc);
-    CapacityConstraint<Material> natu(inventory.quantity(), nc);
+    UpdateConverters_();
+    CapacityConstraint<Material> swu(swu_capacity, swu_converter_);
+    CapacityConstraint<Material> natu(inventory.quantity(), natu_converter_);
     commod_port->AddConstraint(swu);
     commod_port->AddConstraint(natu);
     
@@ -293,6 +332,7 @@ void RandomEnrich::GetMatlTrades(
     const std::vector< cyclus::Trade<cyclus::Material> >& trades,
     std::vector<std::pair<cyclus::Trade<cyclus::Material>,
     cyclus::Material::Ptr> >& responses) {
+  MBMORE_PERF_SCOPE("RandomEnrich", "GetMatlTrades");
 
   using cyclus::Material;
   using cyclus::Trade;
@@ -399,6 +439,7 @@ cyclus::Material::Ptr RandomEnrich::Offer_(cyclus::Material::Ptr mat) {
 cyclus::Material::Ptr RandomEnrich::Enrich_(
     cyclus::Material::Ptr mat,
     double qty) {
+  MBMORE_PERF_SCOPE("RandomEnrich", "Enrich_");
 
   using cyclus::Material;
   using cyclus::ResCast;
@@ -461,6 +502,7 @@ cyclus::Material::Ptr RandomEnrich::Enrich_(
   double heu_definition = 0.2;
   if (u_assay > heu_definition){
     net_heu += qty;
+    AddContamination_(qty);
   }
 
   LOG(cyclus::LEV_INFO5, "EnrFac") << prototype() <<
@@ -503,15 +545,133 @@ void RandomEnrich::RecordRandomEnrich_(double natural_u, double swu) {
       ->AddVal("SWU", swu)
       ->Record();
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RandomEnrich::Contamination() const {
+  if ((contam_half_life <= 0) || (contam_signature == 0)) {
+    return contam_signature;
+  }
+  double elapsed = context()->time() - contam_time;
+  return contam_signature * std::pow(0.5, elapsed/contam_half_life);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Decay the signature to now and add the new HEU, so that the signature is
+// updated per trade without keeping the production history
+void RandomEnrich::AddContamination_(double qty) {
+  contam_signature = Contamination() + qty;
+  contam_time = context()->time();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Every schedule starts at the current time, and all of them are drawn from
+// rng_seed in the same order, so a facility draws the same schedules whether
+// they are built at Build or by its first Tick. After a restart they are
+// redrawn from the restart time.
+void RandomEnrich::BuildSchedules_() {
+  rng_.Seed(rng_seed, id());
+  behavior_ = ParseSocialBehavior(social_behav);
+  BuildTradeSchedule_();
+  BuildTailsSchedule_();
+  ScheduleInspections_();
+  schedules_built_ = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// None trades every timestep. Every trades on multiples of behav_interval, and
+// Random on timesteps chosen with probability 1/behav_interval. With a
+// behav_interval of 0, Every and Random never trade, and Reference never
+// trades.
+void RandomEnrich::BuildTradeSchedule_() {
+  schedule_start_ = context()->time();
+  int n_steps = std::max(0, simdur - schedule_start_);
+  trade_schedule_.assign(n_steps, false);
+
+  if (behavior_ == kNoBehavior) {
+    trade_schedule_.flip();
+  }
+  else if (behavior_ == kEveryBehavior && behav_interval > 0) {
+    for (int step = 0; step < n_steps; step++) {
+      trade_schedule_[step] =
+	EveryXTimestep(schedule_start_ + step, behav_interval);
+    }
+  }
+  else if (behavior_ == kRandomBehavior && behav_interval > 0) {
+    int frequency = behav_interval;
+    if (frequency > 0) {
+      std::vector<int> times =
+	GeometricSchedule(1.0/frequency, schedule_start_, simdur, rng_);
+      for (int i = 0; i < times.size(); i++) {
+	trade_schedule_[times[i] - schedule_start_] = true;
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Variable tails assays are normal about tails_assay, truncated to
+// tails_bounds (or to one sigma_tails either side when not given).
+void RandomEnrich::BuildTailsSchedule_() {
+  tails_schedule_.clear();
+  if (sigma_tails == 0) {
+    return;
+  }
+  double lower = tails_assay - sigma_tails;
+  double upper = tails_assay + sigma_tails;
+  if (!tails_bounds.empty()) {
+    lower = tails_bounds[0];
+    upper = tails_bounds[1];
+  }
+  int n_steps = std::max(0, simdur - schedule_start_);
+  tails_schedule_.resize(n_steps);
+  for (int step = 0; step < n_steps; step++) {
+    tails_schedule_[step] =
+      RNG_TruncNormal(tails_assay, sigma_tails, lower, upper, rng_);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrich::UpdateTailsAssay_(int cur_time) {
+  int step = cur_time - schedule_start_;
+  if ((step >= 0) && (step < tails_schedule_.size())) {
+    curr_tails_assay = tails_schedule_[step];
+  }
+  else {
+    curr_tails_assay = tails_assay;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Only called while bidding on product requests, so that facilities that do
+// not bid never read their feed assay (which pops and pushes the inventory)
+void RandomEnrich::UpdateConverters_() {
+  double feed_assay = FeedAssay();
+  if (!swu_converter_ || (curr_tails_assay != converter_tails_) ||
+      (feed_assay != converter_feed_)) {
+    swu_converter_.reset(new SWUConverter(feed_assay, curr_tails_assay));
+    natu_converter_.reset(new NatUConverter(feed_assay, curr_tails_assay));
+    converter_tails_ = curr_tails_assay;
+    converter_feed_ = feed_assay;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Inspections occur independently on each timestep with probability
+// 1/inspect_freq
+void RandomEnrich::ScheduleInspections_() {
+  inspect_times_.clear();
+  next_inspect_ = 0;
+  if (inspect_freq <= 0) {
+    return;
+  }
+  inspect_times_ = GeometricSchedule(1.0/inspect_freq, schedule_start_,
+				     simdur, rng_);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomEnrich::RecordInspection_() {
   using cyclus::Context;
   using cyclus::Agent;
 
-  std::string sample_location = "Cascade";
-
-  // TODO: Add multiple samples to an inspection, rules about only Cascade
-  // having true positives? Or increased chance of true based on location?
   // TODO: Make HEU definition a State Var (in Tock)
 
   // If HEU has been made, then we see if a perfect swipe test would find it
@@ -520,9 +680,19 @@ void RandomEnrich::RecordInspection_() {
   // scaling with time elapsed because we presume there is increasing
   // contamination. Once contamination would be theoretically measured, this
   // contamination remains for the rest of the simulation.
-  // (TODO: scale with quantity HEU produced)
+  // If contam_scale is set, it instead scales with the quantity of HEU
+  // produced (see AddContamination_)
   double cur_time = double(context()->time());
-  if ((social_behav == "None") && (HEU_present == false)) {
+  if (contam_scale > 0) {
+    // Detection probability follows the quantity of HEU produced and how
+    // long ago it was produced
+    double contam = Contamination();
+    HEU_present = XLikely(1.0 - std::exp(-contam/contam_scale), rng_);
+    MBMORE_LOG(cyclus::LEV_DEBUG2, "EnrFac") << "Inspect Time: " << cur_time
+					     << "  Contamination " << contam
+					     << "  HEU Presence? " << HEU_present;
+  }
+  else if ((behavior_ == kNoBehavior) && (HEU_present == false)) {
     // HEU is produced continuously (as requested), and removed when some
     // quantity has been
     // produced. Risk of leakage increases with time in discrete steps
@@ -530,66 +700,57 @@ void RandomEnrich::RecordInspection_() {
     // it and inspections are still supposed to occur because it assumes
     // that HEU can only be detected if it has been removed from cascades for
     // shipping.
-    std::cout << "Inspect Time: " << cur_time <<  "  Net HEU produced " << net_heu << std::endl;
+    MBMORE_LOG(cyclus::LEV_DEBUG2, "EnrFac") << "Inspect Time: " << cur_time
+					     << "  Net HEU produced " << net_heu;
     if ((net_heu >= heu_ship_qty) && (heu_ship_qty > 0.0)){
-      HEU_present = XLikely(cur_time/(double(simdur) - 1.0), rng_seed);
-      std::cout << "HEU Presence? " << HEU_present << std::endl;
+      HEU_present = XLikely(cur_time/(double(simdur) - 1.0), rng_);
+      MBMORE_LOG(cyclus::LEV_DEBUG2, "EnrFac") << "HEU Presence? "
+					       << HEU_present;
       net_heu -= heu_ship_qty;
     }
   }
   else if ((net_heu > 0.0) && (HEU_present == false)){
     // HEU is made/shipped at specific intervals defined by behavior fns,
     // so test whether any has been made/shipped since last inspection
-    HEU_present = XLikely(cur_time/(double(simdur) - 1.0), rng_seed);
+    HEU_present = XLikely(cur_time/(double(simdur) - 1.0), rng_);
   }
 
-  // Each sample is N swipes, analyzed independently (with a high rate of
-  // false readings in practice).
-  // Based on whether HEU is 'detected' in the sample, determine whether or not
-  // any false positives or negatives change the swipe result.
-  int pos_swipes = 0;
-  int n_false_pos = 0;
-  int n_false_neg = 0;
-  
-  for (int swipeit = 0; swipeit < n_swipes; swipeit++) {
-    double prob;
-    if (HEU_present == true){
-      prob = false_neg;
-    }
-    else {
-      prob = false_pos;
+  // One sample of N swipes is taken at each location. If HEU is present,
+  // it reaches the sample at a location with that location's detection
+  // probability.
+  for (int loc = 0; loc < sample_locations.size(); loc++) {
+    bool heu_in_sample = HEU_present;
+    if (heu_in_sample && !location_detect.empty()) {
+      heu_in_sample = XLikely(location_detect[loc], rng_);
     }
-    bool flip = XLikely(prob, rng_seed);
-    //    std::cout << "Flip? " << flip << std::endl;
-
-    // record false positives, false negatives and net 'positive' swipe results
-    if (flip) {
-      if (!HEU_present){
-	pos_swipes++ ;
-	n_false_pos++;
-      }
-      else {
-	n_false_neg++;
-      }
+
+    // Each swipe is analyzed independently (with a high rate of false
+    // readings in practice). Based on whether HEU is 'detected' in the
+    // sample, determine whether or not any false positives or negatives
+    // change the swipe result. Each swipe flips independently, so the number
+    // of flipped swipes is binomially distributed and is drawn once for the
+    // whole sample.
+    int pos_swipes = 0;
+    int n_false_pos = 0;
+    int n_false_neg = 0;
+    if (heu_in_sample == true){
+      n_false_neg = RNG_Binomial(n_swipes, false_neg, rng_);
+      pos_swipes = n_swipes - n_false_neg;
     }
     else {
-      if (HEU_present) { pos_swipes++; }
+      n_false_pos = RNG_Binomial(n_swipes, false_pos, rng_);
+      pos_swipes = n_false_pos;
     }
-    
-    //    if ((HEU_present && !flip) || (!HEU_present && flip)){
-    //      pos_swipes++;
-    //    }
+
+    context()->NewDatum("Inspections")
+      ->AddVal("AgentID", id())
+      ->AddVal("Time", context()->time())
+      ->AddVal("SampleLoc", sample_locations[loc])
+      ->AddVal("FalsePos", double(n_false_pos)/double(n_swipes))
+      ->AddVal("FalseNeg", double(n_false_neg)/double(n_swipes))
+      ->AddVal("PosSwipeFrac", double(pos_swipes)/double(n_swipes))
+      ->Record();
   }
-    
-  Context* ctx = Agent::context();
-  context()->NewDatum("Inspections")
-    ->AddVal("AgentID", id())
-    ->AddVal("Time", context()->time())
-    ->AddVal("SampleLoc", sample_location)
-    ->AddVal("FalsePos", double(n_false_pos)/double(n_swipes))
-    ->AddVal("FalseNeg", double(n_false_neg)/double(n_swipes))
-    ->AddVal("PosSwipeFrac", double(pos_swipes)/double(n_swipes))
-    ->Record();
 
   /*
   LOG(cyclus::LEV_DEBUG1, "EnrFac") << prototype()
@@ -5,6 +5,7 @@
 
 #include "cyclus.h"
 #include "sim_init.h"
+#include "behavior_functions.h"
 
 namespace mbmore {
 
@@ -257,9 +258,29 @@ class RandomEnrich : public cyclus::Facility {
   double net_heu;
 
   // Presence of heu in the enrichment facility. Once it is present, it will
-  // remain present for the rest of the simulation
+  // remain present for the rest of the simulation (unless contam_scale is
+  // set, in which case it is redrawn from the contamination at each
+  // inspection)
   bool HEU_present;
 
+  // HEU contamination signature (kg) as of contam_time: the HEU produced,
+  // decayed with contam_half_life. Kept as state so that it carries over a
+  // restart.
+  #pragma cyclus var {"default": 0, "internal": True,			\
+                      "tooltip": "HEU contamination signature (kg)",	\
+                      "doc": "HEU produced, decayed with contam_half_life "\
+                             "to contam_time"}
+  double contam_signature;
+
+  #pragma cyclus var {"default": 0, "internal": True,			\
+                      "tooltip": "time of the contamination signature", \
+                      "doc": "timestep at which contam_signature was last "\
+                             "updated"}
+  int contam_time;
+
+  // Contamination signature decayed to the current time
+  double Contamination() const;
+
   // Find the simulation duration
   //  cyclus::SimInfo si_;
   int simdur = context()->sim_info().duration;
@@ -295,6 +316,32 @@ class RandomEnrich : public cyclus::Facility {
   /// unique sampling location
   void RecordInspection_();
 
+  /// @brief adds newly produced HEU (kg) to the contamination signature
+  void AddContamination_(double qty);
+
+  /// @brief seeds rng_ and draws the trade, tails and inspection schedules
+  /// from the current time, at Build or at the first Tick after a restart
+  void BuildSchedules_();
+
+  /// @brief draws the trading timesteps from the current time to the end of
+  /// the simulation according to social_behav
+  void BuildTradeSchedule_();
+
+  /// @brief draws every inspection time from the schedule start to the end
+  /// of the simulation, with an average interval of inspect_freq
+  void ScheduleInspections_();
+
+  /// @brief draws the tails assay for each timestep from the current time to
+  /// the end of the simulation
+  void BuildTailsSchedule_();
+
+  /// @brief sets curr_tails_assay for the current timestep
+  void UpdateTailsAssay_(int cur_time);
+
+  /// @brief rebuilds the SWU and natural U converters used by the bid
+  /// constraints, only when the feed or tails assay has changed
+  void UpdateConverters_();
+
   #pragma cyclus var { \
     "tooltip": "feed commodity",					\
     "doc": "feed commodity that the enrichment facility accepts",	\
@@ -342,6 +389,16 @@ class RandomEnrich : public cyclus::Facility {
   }
   double sigma_tails;  
 
+  #pragma cyclus var {"default": [],					\
+                      "tooltip": "bounds of the tails assay distribution", \
+                      "doc": "Lower and upper limit of the variable tails "\
+                             "assay. Assays are drawn from the normal "	\
+                             "distribution truncated to these bounds. If " \
+                             "not defined the bounds are tails_assay +/- " \
+                             "sigma_tails. Only used if sigma_tails is "	\
+                             "non-zero."}
+  std::vector<double> tails_bounds;
+
   #pragma cyclus var {							\
     "default": 0, "tooltip": "initial uranium reserves (kg)",		\
     "uilabel": "Initial Feed Inventory",				\
@@ -389,7 +446,8 @@ class RandomEnrich : public cyclus::Facility {
                           "doc": "type of social behavior used in trade " \
                                  "decisions: None, Every, Random " \
                                  "where behav_interval describes the " \
-                                 "time interval for behavior action"}
+                                 "time interval for behavior action, or " \
+                                 "Reference, which never trades"}
   std::string social_behav;
 
   #pragma cyclus var {"default": 0, "tooltip": "interval for behavior",\
@@ -412,6 +470,41 @@ class RandomEnrich : public cyclus::Facility {
                              "negative then RNG is queried but no inspections"\
                              "are recorded (to preserve reproducibility)."}
   int inspect_freq;
+
+  #pragma cyclus var {"default": 0, "tooltip": "HEU quantity scale of "	\
+                                 "contamination (kg)",			\
+                      "doc": "If non-zero, HEU presence at an inspection " \
+                             "is drawn with probability 1-exp(-C/"	\
+                             "contam_scale), where C is the contamination "\
+                             "signature (kg) accumulated from the HEU "	\
+                             "produced. If 0, presence instead becomes more "\
+                             "likely linearly with time once HEU has been "\
+                             "produced (or shipped if heu_ship_qty is set)."}
+  double contam_scale;
+
+  #pragma cyclus var {"default": 0, "tooltip": "half life of contamination "\
+                                 "(timesteps)",				\
+                      "doc": "Timesteps for the contamination signature to "\
+                             "decay by half. If 0, contamination does not " \
+                             "decay. Only used if contam_scale is non-zero."}
+  double contam_half_life;
+
+  #pragma cyclus var {"default": ["Cascade"],				\
+                      "tooltip": "locations sampled in each inspection", \
+                      "doc": "Each inspection takes one sample of n_swipes " \
+                             "at every listed location, and records one " \
+                             "row in the Inspections table per location."}
+  std::vector<std::string> sample_locations;
+
+  #pragma cyclus var {"default": [],					\
+                      "tooltip": "probability HEU reaches each sample "	\
+                                 "location",				\
+                      "doc": "For each of the sample_locations, the "	\
+                             "probability (0-1) that the sample contains " \
+                             "HEU contamination when HEU is present in the "\
+                             "facility. If not defined, every location is "\
+                             "contaminated whenever HEU is present."}
+  std::vector<double> location_detect;
  
   #pragma cyclus var {"default": 10, "tooltip": "number of swipes per "	\
                              "inspection sample",      \
@@ -460,6 +553,36 @@ class RandomEnrich : public cyclus::Facility {
   // these help enable time series generation.
   double intra_timestep_swu_;
   double intra_timestep_feed_;
+
+  // Random stream for inspection outcomes, seeded from rng_seed and agent id
+  RNGStream rng_;
+
+  // social_behav, validated at Build and parsed with the schedules
+  SocialBehavior behavior_;
+
+  // Whether the facility trades on each timestep from schedule_start_ to the
+  // end of the simulation, one bit per timestep
+  std::vector<bool> trade_schedule_;
+  int schedule_start_;
+
+  // Tails assay on each timestep from schedule_start_ to the end of the
+  // simulation; empty if sigma_tails is 0
+  std::vector<double> tails_schedule_;
+
+  // Converters for the feed and tails assays of the last bid, shared by
+  // every bid constraint and rebuilt only when either assay changes
+  cyclus::Converter<cyclus::Material>::Ptr swu_converter_;
+  cyclus::Converter<cyclus::Material>::Ptr natu_converter_;
+  double converter_tails_;
+  double converter_feed_;
+
+  // Inspection times drawn at Build, and the position of the next one due
+  std::vector<int> inspect_times_;
+  int next_inspect_;
+
+  // False until the schedules above are drawn. They are not state vars, so
+  // an agent restored from a snapshot draws them at its first Tick.
+  bool schedules_built_;
   
   friend class RandomEnrichTest;
   // ---
@@ -2,6 +2,9 @@
 
 #include "cyclus.h"
 
+#include "RandomEnrich_tests.h"
+#include "alloc_counter_tests.h"
+
 using cyclus::QueryResult;
 using cyclus::Cond;
 using cyclus::CompMap;
@@ -479,6 +482,72 @@ TEST(RandomEnrichTests, TestEvery) {
   
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, TestReferenceBehavior) {
+  // With 'social_behav = Reference' the facility still buys feed but never
+  // supplies product
+
+  std::string config = 
+    "   <feed_commod>natu</feed_commod> "
+    "   <feed_recipe>natu1</feed_recipe> "
+    "   <product_commod>leu</product_commod> "
+    "   <tails_commod>tails</tails_commod> "
+    "   <tails_assay>0.003</tails_assay> "
+    "	<social_behav>Reference</social_behav> "
+    "  	<behav_interval>2</behav_interval> ";
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomEnrich"), config, simdur);
+  sim.AddRecipe("natu1", c_natu1());
+  sim.AddRecipe("leu", c_leu());
+
+  sim.AddSource("natu")
+    .recipe("natu1")
+    .capacity(1)
+    .Finalize();
+
+  sim.AddSink("leu")
+    .capacity(1)
+    .recipe("leu")
+    .Finalize();
+  
+  int id = sim.Run();
+
+  std::vector<Cond> feed_conds;
+  feed_conds.push_back(Cond("Commodity", "==", std::string("natu")));
+  QueryResult feed_qr = sim.db().Query("Transactions", &feed_conds);
+  EXPECT_LT(0, feed_qr.rows.size());
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("leu")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(0, qr.rows.size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, TestUnknownBehavior) {
+  // A misspelled social behavior is rejected when the facility is built
+  // rather than silently never trading
+
+  std::string config = 
+    "   <feed_commod>natu</feed_commod> "
+    "   <feed_recipe>natu1</feed_recipe> "
+    "   <product_commod>leu</product_commod> "
+    "   <tails_commod>tails</tails_commod> "
+    "   <tails_assay>0.003</tails_assay> "
+    "	<social_behav>EveryRandom</social_behav> "
+    "  	<behav_interval>2</behav_interval> ";
+
+  int simdur = 2;
+  EXPECT_THROW({
+      cyclus::MockSim sim(cyclus::AgentSpec
+			  (":mbmore:RandomEnrich"), config, simdur);
+      sim.AddRecipe("natu1", c_natu1());
+      sim.Run();
+    }, cyclus::ValueError);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST(RandomEnrichTests, TestTailsAssay) {
   // When tails has a truncated normal distribution (tails_sigma),
@@ -539,6 +608,53 @@ TEST(RandomEnrichTests, TestTailsAssay) {
 
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, TestTailsBounds) {
+  // With explicit tails_bounds the tails assay is drawn from the normal
+  // distribution truncated to those bounds, even when they exclude the
+  // mean tails_assay
+
+  std::string config = 
+    "   <feed_commod>natu</feed_commod> "
+    "   <feed_recipe>natu1</feed_recipe> "
+    "   <product_commod>enr_u</product_commod> "
+    "   <tails_commod>tails</tails_commod> "
+    "   <tails_assay>0.002</tails_assay> "
+    "   <sigma_tails>0.001</sigma_tails> "
+    "   <tails_bounds> <val>0.0025</val> <val>0.003</val> </tails_bounds> ";
+
+  int simdur = 6;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomEnrich"), config, simdur);
+  sim.AddRecipe("natu1", c_natu1());
+  sim.AddRecipe("leu", c_leu());
+  
+  sim.AddSource("natu")
+    .recipe("natu1")
+    .Finalize();
+  sim.AddSink("enr_u")
+    .recipe("leu")
+    .capacity(1.0)
+    .Finalize();
+   sim.AddSink("tails")
+    .Finalize();
+  
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("tails")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_GT(qr.rows.size(), 0);
+
+  for (int i = 0; i < qr.rows.size(); i++) {
+    int res_id = qr.GetVal<int>("ResourceId", i);
+    cyclus::toolkit::MatQuery mq(sim.GetMaterial(res_id));
+    double t = mq.mass(922350000)/(mq.mass(922350000) + mq.mass(922380000));
+    EXPECT_GE(t, 0.0025 - 1e-9);
+    EXPECT_LE(t, 0.003 + 1e-9);
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST(RandomEnrichTests, TestInspectionNegatives) {
   // Inspections occur with an average frequency (50%),
@@ -649,6 +765,108 @@ TEST(RandomEnrichTests, TestInspectionPositives) {
   EXPECT_NEAR(pos_rate, 0.5, eps);
 
   } 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, TestSampleLocations) {
+  // Each inspection samples every location. HEU always reaches the Cascade
+  // sample once present, and never reaches the Feed sample.
+
+ std::string config = 
+    "   <feed_commod>natu</feed_commod> "
+    "   <feed_recipe>natu1</feed_recipe> "
+    "   <product_commod>enr_u</product_commod> "
+    "   <tails_commod>tails</tails_commod> "
+    "   <tails_assay>0.002</tails_assay> "
+    "   <social_behav>Every</social_behav> "
+    "   <behav_interval>1</behav_interval> "
+    "   <inspect_freq>1</inspect_freq> "
+    "   <sample_locations> <val>Cascade</val> <val>Feed</val> "
+    "   </sample_locations> "
+    "   <location_detect> <val>1</val> <val>0</val> </location_detect> "
+    "   <n_swipes>10</n_swipes> ";
+
+  int simdur = 10;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomEnrich"), config, simdur);
+  sim.AddRecipe("natu1", c_natu1());
+  sim.AddRecipe("enr_u", c_heu90());
+  
+  sim.AddSource("natu")
+    .recipe("natu1")
+    .capacity(1.0)
+    .Finalize();
+  sim.AddSink("enr_u")
+    .recipe("enr_u")
+    .Finalize();
+  
+  int id = sim.Run();
+  std::vector<Cond> cascade;
+  cascade.push_back(Cond("SampleLoc", "==", std::string("Cascade")));
+  QueryResult qr_cascade = sim.db().Query("Inspections", &cascade);
+  std::vector<Cond> feed;
+  feed.push_back(Cond("SampleLoc", "==", std::string("Feed")));
+  QueryResult qr_feed = sim.db().Query("Inspections", &feed);
+
+  // inspect_freq of 1 inspects every timestep
+  EXPECT_EQ(simdur, static_cast<int>(qr_cascade.rows.size()));
+  EXPECT_EQ(simdur, static_cast<int>(qr_feed.rows.size()));
+
+  double feed_tot = 0;
+  double cascade_max = 0;
+  for (int it = 0; it < qr_feed.rows.size(); it++) {
+    feed_tot += qr_feed.GetVal<double>("PosSwipeFrac", it);
+    cascade_max = std::max(cascade_max,
+			   qr_cascade.GetVal<double>("PosSwipeFrac", it));
+  }
+  EXPECT_EQ(0, feed_tot);
+  // HEU is certainly present by the last timestep
+  EXPECT_EQ(1, cascade_max);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomEnrichTests, TestContamination) {
+  // With a tiny contamination scale, any HEU produced is detected at the next
+  // inspection. With a huge one, a few kg of HEU is (almost) never detected.
+  double scales[2] = {1e-6, 1e6};
+  for (int s = 0; s < 2; s++) {
+    std::stringstream config;
+    config << "   <feed_commod>natu</feed_commod> "
+	   << "   <feed_recipe>natu1</feed_recipe> "
+	   << "   <product_commod>enr_u</product_commod> "
+	   << "   <tails_commod>tails</tails_commod> "
+	   << "   <tails_assay>0.002</tails_assay> "
+	   << "   <inspect_freq>1</inspect_freq> "
+	   << "   <contam_scale>" << scales[s] << "</contam_scale> "
+	   << "   <contam_half_life>2</contam_half_life> "
+	   << "   <n_swipes>10</n_swipes> ";
+
+    int simdur = 6;
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomEnrich"), config.str(), simdur);
+    sim.AddRecipe("natu1", c_natu1());
+    sim.AddRecipe("enr_u", c_heu90());
+  
+    sim.AddSource("natu")
+      .recipe("natu1")
+      .capacity(1.0)
+      .Finalize();
+    sim.AddSink("enr_u")
+      .recipe("enr_u")
+      .Finalize();
+  
+    int id = sim.Run();
+    std::vector<Cond> conds;
+    conds.push_back(Cond("SampleLoc", "==", std::string("Cascade")));
+    QueryResult qr = sim.db().Query("Inspections", &conds);
+    int n_inspect = qr.rows.size();
+    ASSERT_EQ(simdur, n_inspect);
+
+    // no HEU has been made at the first inspection
+    EXPECT_EQ(0, qr.GetVal<double>("PosSwipeFrac", 0));
+    double expect_last = (s == 0) ? 1 : 0;
+    EXPECT_EQ(expect_last, qr.GetVal<double>("PosSwipeFrac", n_inspect - 1));
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   TEST(RandomEnrichTests, TestHeuShipQty) {
     // Even though inspections are set to occur every timestep, HEU is not
@@ -696,4 +914,112 @@ TEST(RandomEnrichTests, TestInspectionPositives) {
   } 
 
 } // namespace randomenrichtests
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrichTest::SetUp() {
+  cyclus::Env::SetNucDataPath();
+  cyclus::Context* ctx = tc_.get();
+  src_facility = new RandomEnrich(ctx);
+  trader = tc_.trader();
+
+  feed_commod = "incommod";
+  product_commod = "outcommod";
+  tails_commod = "tailscommod";
+  feed_recipe = "recipe";
+  feed_assay = 0.0072;
+  tails_assay = 0.002;
+  swu_capacity = 100;
+  inv_size = 5;
+
+  cyclus::CompMap v;
+  v[922350000] = feed_assay;
+  v[922380000] = 1 - feed_assay;
+  ctx->AddRecipe(feed_recipe, cyclus::Composition::CreateFromAtom(v));
+
+  src_facility->feed_recipe = feed_recipe;
+  src_facility->feed_commod = feed_commod;
+  src_facility->product_commod = product_commod;
+  src_facility->tails_commod = tails_commod;
+  src_facility->tails_assay = tails_assay;
+  src_facility->swu_capacity = swu_capacity;
+  src_facility->max_feed_inventory = inv_size;
+  src_facility->inventory.capacity(inv_size);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrichTest::TearDown() { delete src_facility; }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+cyclus::Material::Ptr RandomEnrichTest::GetMat(double qty) {
+  return cyclus::Material::CreateUntracked(qty,
+                                           tc_.get()->GetRecipe(feed_recipe));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrichTest::DoAddMat(cyclus::Material::Ptr mat) {
+  src_facility->AddMat_(mat);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomEnrichTest::DropSchedules() {
+  src_facility->trade_schedule_.clear();
+  src_facility->tails_schedule_.clear();
+  src_facility->inspect_times_.clear();
+  src_facility->next_inspect_ = 0;
+  src_facility->schedules_built_ = false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+cyclus::Converter<cyclus::Material>::Ptr RandomEnrichTest::SwuConverter() {
+  return src_facility->swu_converter_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Converters are only built when bidding on product, and reused while the
+// feed and tails assays are unchanged
+TEST_F(RandomEnrichTest, ConvertersBuiltWhenBidding) {
+  DoAddMat(GetMat(inv_size));
+  src_facility->Tick();
+  EXPECT_TRUE(SwuConverter().get() == NULL);
+
+  Material::Ptr target =
+      Material::CreateUntracked(1, randomenrichtests::c_leu());
+  cyclus::Request<Material>* req =
+      cyclus::Request<Material>::Create(target, trader, product_commod);
+  cyclus::CommodMap<Material>::type requests;
+  requests[product_commod].push_back(req);
+
+  src_facility->GetMatlBids(requests);
+  cyclus::Converter<Material>::Ptr first = SwuConverter();
+  ASSERT_TRUE(first.get() != NULL);
+  src_facility->Tick();
+  src_facility->GetMatlBids(requests);
+  EXPECT_EQ(first, SwuConverter());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Build is not called when restarting from a snapshot, so a facility without
+// schedules draws them at its next Tick and keeps trading
+TEST_F(RandomEnrichTest, SchedulesDrawnAfterRestart) {
+  src_facility->simdur = 10;
+  src_facility->Tick();
+  EXPECT_TRUE(src_facility->trade_timestep);
+
+  DropSchedules();
+  src_facility->trade_timestep = false;
+  src_facility->Tick();
+  EXPECT_TRUE(src_facility->trade_timestep);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Reports the allocations of each timestep phase for comparison between
+// commits
+TEST_F(RandomEnrichTest, PhaseAllocations) {
+  Material::Ptr target =
+      Material::CreateUntracked(1, randomenrichtests::c_leu());
+
+  DoAddMat(GetMat(inv_size));
+  ReportPhaseAllocs(src_facility, trader, product_commod, target);
+}
+
 } // namespace mbmore
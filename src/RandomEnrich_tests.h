@@ -0,0 +1,34 @@
+#ifndef MBMORE_SRC_RANDOMENRICH_TESTS_
+#define MBMORE_SRC_RANDOMENRICH_TESTS_
+
+#include <gtest/gtest.h>
+
+#include "test_context.h"
+
+#include "RandomEnrich.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A RandomEnrich driven phase by phase, outside of a simulation
+class RandomEnrichTest : public ::testing::Test {
+ protected:
+  cyclus::TestContext tc_;
+  RandomEnrich* src_facility;
+  TestFacility* trader;
+  std::string feed_commod, product_commod, tails_commod, feed_recipe;
+
+  double feed_assay, tails_assay, inv_size, swu_capacity;
+
+  virtual void SetUp();
+  virtual void TearDown();
+  cyclus::Material::Ptr GetMat(double qty);
+  void DoAddMat(cyclus::Material::Ptr mat);
+  /// Forget the drawn schedules, as an agent restored from a snapshot has
+  void DropSchedules();
+  /// The SWU converter of the last bid, if any
+  cyclus::Converter<cyclus::Material>::Ptr SwuConverter();
+};
+
+}  // namespace mbmore
+#endif  // MBMORE_SRC_RANDOMENRICH_TESTS_
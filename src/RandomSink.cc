@@ -6,6 +6,8 @@
 
 #include "RandomSink.h"
 #include "behavior_functions.h"
+#include "mbmore_log.h"
+#include "perf_timers.h"
 
 namespace mbmore {
 
@@ -18,7 +20,14 @@ RandomSink::RandomSink(cyclus::Context* ctx)
       user_pref(1), //***
       sigma(0), //***
       t_trade(0), //***
-      max_inv_size(1e299) {}  // actually only used in header file
+      max_inv_size(1e299),  // actually only used in header file
+      behavior_(kNoBehavior),
+      constant_(false),
+      schedule_start_(0),
+      next_trade_(0),
+      schedule_built_(false),
+      matl_target_amt_(0),
+      rsrc_target_amt_(0) {}
 
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -65,6 +74,7 @@ std::string RandomSink::str() {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
 RandomSink::GetMatlRequests() {
+  MBMORE_PERF_SCOPE("RandomSink", "GetMatlRequests");
   using cyclus::Material;
   using cyclus::RequestPortfolio;
   using cyclus::Request;
@@ -77,18 +87,24 @@ RandomSink::GetMatlRequests() {
     return ports;
   }
 
-  // otherwise, respond to all requests
+  // otherwise, respond to all requests. The exchange expects a new
+  // portfolio every timestep, but the requested material is only rebuilt
+  // when its amount or recipe has changed.
   RequestPortfolio<Material>::Ptr port(new RequestPortfolio<Material>());
 
-  Material::Ptr mat;
-
-  // if no recipe has been specified in either format
-  if (recipe_name.empty() and (recipe_names.size() == 0)) {
-    mat = cyclus::NewBlankMaterial(amt);
-  } else {
-    //***    Composition::Ptr rec = this->context()->GetRecipe(recipe_name);
-    mat = cyclus::Material::CreateUntracked(amt, curr_recipe); 
-  } 
+  if (!matl_target_ || (amt != matl_target_amt_) ||
+      (curr_recipe != matl_target_recipe_)) {
+    // if no recipe has been specified in either format
+    if (recipe_name.empty() and (recipe_names.size() == 0)) {
+      matl_target_ = cyclus::NewBlankMaterial(amt);
+    } else {
+      //***    Composition::Ptr rec = this->context()->GetRecipe(recipe_name);
+      matl_target_ = cyclus::Material::CreateUntracked(amt, curr_recipe); 
+    }
+    matl_target_amt_ = amt;
+    matl_target_recipe_ = curr_recipe;
+  }
+  Material::Ptr mat = matl_target_;
 
   if (amt > cyclus::eps()) {
     std::vector<std::string>::const_iterator it;
@@ -112,18 +128,22 @@ RandomSink::GetGenRsrcRequests() {
   using cyclus::Request;
 
   std::set<RequestPortfolio<Product>::Ptr> ports;
-  RequestPortfolio<Product>::Ptr
-      port(new RequestPortfolio<Product>());
 
   if (amt > cyclus::eps()) {
+    if (!rsrc_target_ || (amt != rsrc_target_amt_)) {
+      std::string quality = "";  // not clear what this should be..
+      rsrc_target_ = Product::CreateUntracked(amt, quality);
+      rsrc_target_amt_ = amt;
+    }
+
+    RequestPortfolio<Product>::Ptr
+      port(new RequestPortfolio<Product>());
     CapacityConstraint<Product> cc(amt);
     port->AddConstraint(cc);
 
     std::vector<std::string>::const_iterator it;
     for (it = in_commods.begin(); it != in_commods.end(); ++it) {
-      std::string quality = "";  // not clear what this should be..
-      Product::Ptr rsrc = Product::CreateUntracked(amt, quality);
-      port->AddRequest(rsrc, this, *it);
+      port->AddRequest(rsrc_target_, this, *it);
     }
 
     ports.insert(port);
@@ -135,6 +155,7 @@ RandomSink::GetGenRsrcRequests() {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomSink::AdjustMatlPrefs(
   cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_PERF_SCOPE("RandomSink", "AdjustMatlPrefs");
 
   using cyclus::Bid;
   using cyclus::Material;
@@ -172,58 +193,168 @@ void RandomSink::AcceptGenRsrcTrades(
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void RandomSink::Tick() {
-  using std::string;
-  using std::vector;
-  LOG(cyclus::LEV_INFO3, "SnkFac") << prototype() << " is ticking {";
+void RandomSink::Build(cyclus::Agent* parent) {
+  cyclus::Facility::Build(parent);
+  if (ParseSocialBehavior(social_behav) == kUnknownBehavior) {
+    throw cyclus::ValueError("RandomSink social_behav must be None, Every, "
+			     "Random or Reference, not " + social_behav);
+  }
+  BuildSchedule_();
+}
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The schedule starts at the current time and is drawn from rng_seed, so a
+// sink draws the same schedule whether it is built at Build or by its first
+// Tick. After a restart it is redrawn from the restart time.
+void RandomSink::BuildSchedule_() {
+  rng_.Seed(rng_seed, id());
+  behavior_ = ParseSocialBehavior(social_behav);
+  ResolveRecipes_();
+  schedule_built_ = true;
+  constant_ = (behavior_ == kNoBehavior) && (sigma == 0) &&
+    (recipes_.size() <= 1) && (t_trade <= context()->time());
+  if (constant_) {
+    curr_recipe = recipes_.empty() ? cyclus::Composition::Ptr() : recipes_[0];
+    return;
+  }
+  BuildTradeSchedule_();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSink::ResolveRecipes_() {
+  recipes_.clear();
+  if (!recipe_names.empty()) {
+    for (int i = 0; i < recipe_names.size(); i++) {
+      recipes_.push_back(context()->GetRecipe(recipe_names[i]));
+    }
+  }
+  else if (!recipe_name.empty()) {
+    recipes_.push_back(context()->GetRecipe(recipe_name));
+  }
+
+  if (recipe_weights.empty()) {
+    recipe_table_.Build(std::vector<double>(recipes_.size(), 1.0));
+    return;
+  }
+  if (recipe_weights.size() != recipe_names.size()) {
+    throw cyclus::ValueError("recipe_weights must have one weight for each "
+			     "of the recipe_names");
+  }
+  double total = 0;
+  for (int i = 0; i < recipe_weights.size(); i++) {
+    if (recipe_weights[i] < 0) {
+      throw cyclus::ValueError("recipe_weights must not be negative");
+    }
+    total += recipe_weights[i];
+  }
+  if (total <= 0) {
+    throw cyclus::ValueError("at least one of the recipe_weights must be "
+			     "positive");
+  }
+  recipe_table_.Build(recipe_weights);
+}
 
-  // Determine the correct recipe for the timestep. If only one recipe
-  // is given then use that recipe. If multiple recipes are given, choose
-  // one randomly
-  int n_recipes = recipe_names.size();
-  if (n_recipes > 0) {
-    int curr_recipe_index = RNG_Integer(0.0, n_recipes, rng_seed);
-    curr_recipe = context()->GetRecipe(recipe_names[curr_recipe_index]);
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Trading requires t >= t_trade and, depending on social_behav, a timestep
+// that is a multiple of behav_interval (Every) or that is randomly chosen
+// with probability 1/behav_interval (Random). Reference draws the same
+// random timesteps as Random, but never trades.
+void RandomSink::BuildTradeSchedule_() {
+  int simdur = context()->sim_info().duration;
+  schedule_start_ = context()->time();
+  int n_steps = std::max(0, simdur - schedule_start_);
+  trade_schedule_.assign(n_steps, false);
+  next_trade_ = 0;
+
+  bool random_behav = (behavior_ == kRandomBehavior) ||
+    (behavior_ == kReferenceBehavior);
+  if (random_behav) {
+    int frequency = behav_interval;
+    if (frequency > 0) {
+      std::vector<int> times =
+	GeometricSchedule(1.0/frequency, schedule_start_, simdur, rng_);
+      for (int i = 0; i < times.size(); i++) {
+	trade_schedule_[times[i] - schedule_start_] = true;
+      }
+    }
   }
   else {
-    curr_recipe = context()->GetRecipe(recipe_name);
+    trade_schedule_.flip();
   }
-  
-  // set the amount to be requested on this timestep
-  // then determine whether trading will happen on this timestep. If not
-  // then change the requested material to zero.
-  int cur_time = context()->time();
-  
-  /// determine the amount to request
+
+  int n_trades = 0;
+  for (int step = 0; step < n_steps; step++) {
+    int t = schedule_start_ + step;
+    if ((t < t_trade) || (behavior_ == kReferenceBehavior) ||
+	((behavior_ == kEveryBehavior) && (behav_interval > 0) &&
+	 !EveryXTimestep(t, behav_interval))) {
+      trade_schedule_[step] = false;
+    }
+    if (trade_schedule_[step]) {
+      n_trades++;
+    }
+  }
+
   // If sigma=0 then RNG is not queried
-  double desired_amt = RNG_NormalDist(avg_qty, sigma, rng_seed);
-  amt = std::min(desired_amt, std::max(0.0, inventory.space()));
+  qty_schedule_.clear();
+  if ((sigma != 0) && (n_trades > 0)) {
+    qty_schedule_.resize(n_trades);
+    rng_.FillNormal(avg_qty, sigma, &qty_schedule_[0], n_trades);
+  }
 
-  if (cur_time < t_trade) {
-    std::cout << "Amt is zero because curr time " << cur_time << " <t_trade" << t_trade << std::endl;
-    amt = 0;
+  // If multiple recipes are given, choose one randomly for each trade
+  recipe_schedule_.clear();
+  if (recipes_.size() > 1) {
+    recipe_schedule_.resize(n_trades);
+    for (int i = 0; i < n_trades; i++) {
+      recipe_schedule_[i] = recipe_table_.Sample(rng_);
+    }
   }
-  if (social_behav == "Every" && behav_interval > 0) {
-    if (!EveryXTimestep(cur_time, behav_interval)) // HEU every X time
-      {
-    std::cout << "Amt is zero because EVERY and interval > 0 " << std::endl;
-	amt = 0;
-      }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSink::Tick() {
+  MBMORE_PERF_TICK("RandomSink", context());
+  using std::string;
+  using std::vector;
+  LOG(cyclus::LEV_INFO3, "SnkFac") << prototype() << " is ticking {";
+
+  // A restart from a snapshot does not call Build, so the schedule is drawn
+  // here instead
+  if (!schedule_built_) {
+    BuildSchedule_();
   }
-  // Call EveryRandom only if the agent REALLY want it (dummyproofing)
-  else if ((social_behav == "Random") && (amt > 0)){
-    if (!EveryRandomXTimestep(behav_interval, rng_seed)) // HEU randomly one in X times
-      {
-	std::cout << "Amt is zero because Random is negatvive " << std::endl;
-	amt = 0;
-      }
+
+  // Deterministic sinks request avg_qty of their one recipe every timestep
+  if (constant_) {
+    amt = std::min(avg_qty, std::max(0.0, inventory.space()));
+    LOG(cyclus::LEV_INFO3, "SnkFac") << "}";
+    return;
   }
-  // If reference, query RNG but force trade as zero quantity.
-  else if ((social_behav == "Reference") && (amt > 0)){
-    bool res = EveryRandomXTimestep(behav_interval, rng_seed);
-    std::cout << "Amt is zero because Reference superficially queries RNG " << std::endl;
-    amt = 0;
+
+  // Whether trading will happen on this timestep, the amount to request and
+  // the recipe were all drawn when the facility was built. If not trading,
+  // the requested amount is zero.
+  int step = context()->time() - schedule_start_;
+  amt = 0;
+  if ((step >= 0) && (step < trade_schedule_.size()) &&
+      trade_schedule_[step]) {
+    int trade = next_trade_++;
+    double desired_amt = qty_schedule_.empty() ? avg_qty : qty_schedule_[trade];
+    amt = std::min(desired_amt, std::max(0.0, inventory.space()));
+
+    // If only one recipe is given then use that recipe.
+    if (recipes_.size() > 1) {
+      curr_recipe = recipes_[recipe_schedule_[trade]];
+    }
+    else if (recipes_.size() == 1) {
+      curr_recipe = recipes_[0];
+    }
+  }
+  else {
+    MBMORE_LOG(cyclus::LEV_DEBUG2, "SnkFac")
+      << "Amt is zero because " << social_behav
+      << " behavior does not trade at " << context()->time();
   }
   
   // inform the simulation about what the sink facility will be requesting
@@ -240,6 +371,7 @@ void RandomSink::Tick() {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void RandomSink::Tock() {
+  MBMORE_PERF_TOCK("RandomSink", context());
   LOG(cyclus::LEV_INFO3, "SnkFac") << prototype() << " is tocking {";
 
   // On the tock, the sink facility doesn't really do much.
@@ -52,6 +52,9 @@ class RandomSink : public cyclus::Facility  {
 
   virtual std::string str();
 
+  /// Seeds the RNG stream and precomputes the trading schedule
+  virtual void Build(cyclus::Agent* parent);
+
   virtual void Tick();
 
   virtual void Tock();
@@ -90,6 +93,62 @@ class RandomSink : public cyclus::Facility  {
   cyclus::Composition::Ptr curr_recipe;
   
  private:
+  /// @brief looks up the compositions of recipe_name or recipe_names and
+  /// builds the table that recipes are drawn from
+  void ResolveRecipes_();
+
+  /// @brief seeds rng_, resolves the recipes and draws the trade schedule
+  /// from the current time, at Build or at the first Tick after a restart
+  void BuildSchedule_();
+
+  /// @brief draws the trading timesteps, and the quantity and recipe for
+  /// each trade, from the current time to the end of the simulation
+  void BuildTradeSchedule_();
+
+  // Random stream for trade decisions, seeded from rng_seed and agent id
+  RNGStream rng_;
+
+  // social_behav, validated at Build and parsed with the schedule
+  SocialBehavior behavior_;
+
+  // True when every timestep requests the same amount of the same recipe
+  // (no social behavior, sigma of 0, at most one recipe and no delay before
+  // trading), so that Tick needs no schedule lookups
+  bool constant_;
+
+  // Whether the facility trades on each timestep from schedule_start_ to the
+  // end of the simulation, one bit per timestep
+  std::vector<bool> trade_schedule_;
+  int schedule_start_;
+
+  // Requested quantity and recipe index for each trade, in the order of the
+  // trading timesteps. Empty if sigma is 0 (avg_qty is always requested) or
+  // there is only one recipe.
+  std::vector<double> qty_schedule_;
+  std::vector<int> recipe_schedule_;
+
+  // Position in qty_schedule_ and recipe_schedule_ of the next trade
+  int next_trade_;
+
+  // False until the schedule above is drawn. It is not state, so an agent
+  // restored from a snapshot draws it at its first Tick.
+  bool schedule_built_;
+
+  // Compositions of recipe_names (or of recipe_name alone), resolved with
+  // the schedule, and the table recipe indices are drawn from
+  std::vector<cyclus::Composition::Ptr> recipes_;
+  AliasTable recipe_table_;
+
+  // Requested resources of the last timestep that requested, shared by the
+  // new portfolio of each timestep while their amount and recipe are
+  // unchanged
+  cyclus::Material::Ptr matl_target_;
+  double matl_target_amt_;
+  cyclus::Composition::Ptr matl_target_recipe_;
+
+  cyclus::Product::Ptr rsrc_target_;
+  double rsrc_target_amt_;
+
   /// all facilities must have at least one input commodity
   #pragma cyclus var {"tooltip": "input commodities", \
                       "doc": "commodities that the sink facility accepts", \
@@ -113,6 +172,14 @@ class RandomSink : public cyclus::Facility  {
             "(randomly chosen)", \
   }
   std::vector<std::string> recipe_names;
+
+  #pragma cyclus var {"default": [],					\
+    "tooltip": "relative weight of each recipe",				\
+    "doc": "Relative probability of requesting each of the recipe_names " \
+           "on a trading timestep. If not defined, every recipe is equally " \
+           "likely.", \
+  }
+  std::vector<double> recipe_weights;
   
   //***
   #pragma cyclus var {"default": "None", "tooltip": "social behavior",	\
@@ -179,6 +246,8 @@ class RandomSink : public cyclus::Facility  {
   /// this facility holds material in storage.
   #pragma cyclus var {'capacity': 'max_inv_size'}
   cyclus::toolkit::ResBuf<cyclus::Resource> inventory;
+
+  friend class RandomSinkTest;
 };
 
 }  // namespace mbmore
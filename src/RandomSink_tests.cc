@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <sstream>
+
 #include "cyclus.h"
 
+#include "RandomSink_tests.h"
+
 using cyclus::QueryResult;
 using cyclus::Cond;
 using cyclus::CompMap;
@@ -31,6 +36,64 @@ Composition::Ptr c_heu() {
   return Composition::CreateFromMass(m);
 };
   
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::SetUp() { recipe = c_leu(); }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::TearDown() {
+  for (int i = 0; i < sinks.size(); i++) {
+    delete sinks[i];
+  }
+  sinks.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RandomSink* RandomSinkTest::NewSink(int n_commods) {
+  RandomSink* sink = new RandomSink(tc_.get());
+  for (int i = 0; i < n_commods; i++) {
+    std::stringstream commod;
+    commod << "commod_" << i;
+    sink->in_commods.push_back(commod.str());
+  }
+  sink->recipe_name = "leu";
+  sinks.push_back(sink);
+  return sink;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::SetRequest(RandomSink* sink, double amt,
+				Composition::Ptr comp) {
+  sink->amt = amt;
+  sink->curr_recipe = comp;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::AddCommod(RandomSink* sink, const std::string& commod) {
+  sink->in_commods.push_back(commod);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::ClearRequestCache(RandomSink* sink) {
+  sink->matl_target_.reset();
+  sink->rsrc_target_.reset();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::SetEvery(RandomSink* sink, double interval, double qty) {
+  sink->social_behav = "Every";
+  sink->behav_interval = interval;
+  sink->avg_qty = qty;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RandomSinkTest::DropSchedule(RandomSink* sink) {
+  sink->trade_schedule_.clear();
+  sink->qty_schedule_.clear();
+  sink->recipe_schedule_.clear();
+  sink->next_trade_ = 0;
+  sink->schedule_built_ = false;
+}
+
 namespace randomsinktests {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST(RandomSinkTests, TestEvery) {
@@ -141,9 +204,302 @@ TEST(RandomSinkTests, TestTradeTime) {
   EXPECT_EQ(2.0, qr.rows.size());
   
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomSinkTests, TestRandomSchedule) {
+  // Random trading timesteps are drawn from the sink's own RNG stream, so the
+  // same seed gives the same trades, in about 1 of behav_interval timesteps
+
+  std::string config = 
+    "   <in_commods><val>leu</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> "
+    "	<social_behav>Random</social_behav> "
+    "  	<behav_interval>4</behav_interval> "
+    "   <rng_seed>7</rng_seed> ";
+
+  int simdur = 200;
+  std::vector<std::vector<int> > trade_times(2);
+  for (int run = 0; run < 2; run++) {
+    cyclus::MockSim sim(cyclus::AgentSpec
+			(":mbmore:RandomSink"), config, simdur);
+    sim.AddRecipe("leu", c_leu());
+  
+    sim.AddSource("leu")
+      .capacity(1)
+      .recipe("leu")
+      .Finalize();
+  
+    int id = sim.Run();
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Commodity", "==", std::string("leu")));
+    QueryResult qr = sim.db().Query("Transactions", &conds);
+    for (int it = 0; it < qr.rows.size(); it++) {
+      trade_times[run].push_back(qr.GetVal<int>("Time", it));
+    }
+  }
+  EXPECT_EQ(trade_times[0], trade_times[1]);
+  EXPECT_NEAR(0.25, double(trade_times[0].size())/simdur, 0.1);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomSinkTests, TestRecipeWeights) {
+  // A recipe with zero weight is never requested, so every trade from a
+  // source that matches the requested composition is HEU
+
+  std::string config = 
+    "   <in_commods><val>fuel</val></in_commods> "
+    "   <recipe_names><val>leu</val><val>heu</val></recipe_names> "
+    "   <recipe_weights><val>0</val><val>1</val></recipe_weights> "
+    "   <rng_seed>3</rng_seed> ";
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomSink"), config, simdur);
+  sim.AddRecipe("leu", c_leu());
+  sim.AddRecipe("heu", c_heu());
+  
+  sim.AddSource("fuel")
+    .capacity(1)
+    .Finalize();
+  
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("fuel")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(simdur, qr.rows.size());
+
+  for (int it = 0; it < qr.rows.size(); it++) {
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", it));
+    MatQuery mq(m);
+    double enrich = mq.mass(922350000)/
+      (mq.mass(922350000) + mq.mass(922380000));
+    EXPECT_NEAR(0.20, enrich, 1e-9);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomSinkTests, TestConstantSink) {
+  // With no social behavior, no sigma and one recipe, the sink requests
+  // avg_qty on every timestep
+
+  std::string config = 
+    "   <in_commods><val>leu</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> "
+    "   <avg_qty>2</avg_qty> ";
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomSink"), config, simdur);
+  sim.AddRecipe("leu", c_leu());
+  
+  sim.AddSource("leu")
+    .capacity(10)
+    .recipe("leu")
+    .Finalize();
+  
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("leu")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(simdur, qr.rows.size());
+  for (int it = 0; it < qr.rows.size(); it++) {
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", it));
+    EXPECT_DOUBLE_EQ(2, m->quantity());
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(RandomSinkTest, RequestCache) {
+  // Every request gets a new portfolio, which shares the requested resource
+  // of the last one while amt and recipe are unchanged
+  RandomSink* sink = NewSink(3);
+  SetRequest(sink, 10, recipe);
+
+  typedef cyclus::RequestPortfolio<Material>::Ptr MatlPort;
+  typedef cyclus::RequestPortfolio<cyclus::Product>::Ptr RsrcPort;
+  MatlPort first = *sink->GetMatlRequests().begin();
+  MatlPort second = *sink->GetMatlRequests().begin();
+  EXPECT_NE(first, second);
+  ASSERT_EQ(3, second->requests().size());
+  EXPECT_EQ(first->requests()[0]->target(), second->requests()[0]->target());
+  RsrcPort first_rsrc = *sink->GetGenRsrcRequests().begin();
+  RsrcPort second_rsrc = *sink->GetGenRsrcRequests().begin();
+  EXPECT_NE(first_rsrc, second_rsrc);
+  EXPECT_EQ(first_rsrc->requests()[0]->target(),
+            second_rsrc->requests()[0]->target());
+
+  SetRequest(sink, 5, recipe);
+  MatlPort new_amt = *sink->GetMatlRequests().begin();
+  EXPECT_NE(second->requests()[0]->target(), new_amt->requests()[0]->target());
+  EXPECT_DOUBLE_EQ(5, new_amt->qty());
+  RsrcPort new_amt_rsrc = *sink->GetGenRsrcRequests().begin();
+  EXPECT_DOUBLE_EQ(5, new_amt_rsrc->requests()[0]->target()->quantity());
+
+  Composition::Ptr heu = c_heu();
+  SetRequest(sink, 5, heu);
+  MatlPort new_recipe = *sink->GetMatlRequests().begin();
+  EXPECT_EQ(heu, new_recipe->requests()[0]->target()->comp());
+
+  AddCommod(sink, "commod_3");
+  EXPECT_EQ(4, (*sink->GetMatlRequests().begin())->requests().size());
+  EXPECT_EQ(4, (*sink->GetGenRsrcRequests().begin())->requests().size());
+
+  SetRequest(sink, 0, recipe);
+  EXPECT_TRUE(sink->GetMatlRequests().empty());
+  EXPECT_TRUE(sink->GetGenRsrcRequests().empty());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(RandomSinkTest, ScheduleDrawnAfterRestart) {
+  // Build is not called when restarting from a snapshot, so a sink without a
+  // schedule draws it at its next Tick and keeps requesting
+  tc_.get()->InitSim(cyclus::SimInfo(10));
+  tc_.get()->AddRecipe("leu", recipe);
+  RandomSink* sink = NewSink(1);
+  SetEvery(sink, 1, 2);
+  sink->Tick();
+  EXPECT_DOUBLE_EQ(2, sink->amt);
+
+  DropSchedule(sink);
+  sink->amt = 0;
+  sink->Tick();
+  EXPECT_DOUBLE_EQ(2, sink->amt);
+  EXPECT_EQ(1, sink->GetMatlRequests().size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(RandomSinkTest, RequestCacheMatchesRebuilt) {
+  // Portfolios on a cached target ask for the same requests as ones built
+  // from scratch
+  RandomSink* sink = NewSink(5);
+  SetRequest(sink, 1.0, recipe);
+  for (int t = 0; t < 3; t++) {
+    cyclus::RequestPortfolio<Material>::Ptr cached =
+      *sink->GetMatlRequests().begin();
+    ClearRequestCache(sink);
+    cyclus::RequestPortfolio<Material>::Ptr rebuilt =
+      *sink->GetMatlRequests().begin();
+    ASSERT_EQ(rebuilt->requests().size(), cached->requests().size());
+    EXPECT_DOUBLE_EQ(rebuilt->qty(), cached->qty());
+    for (int i = 0; i < rebuilt->requests().size(); i++) {
+      cyclus::Request<Material>* r = rebuilt->requests()[i];
+      cyclus::Request<Material>* c = cached->requests()[i];
+      EXPECT_EQ(r->commodity(), c->commodity());
+      EXPECT_DOUBLE_EQ(r->target()->quantity(), c->target()->quantity());
+      EXPECT_EQ(r->target()->comp(), c->target()->comp());
+      EXPECT_EQ(r->requester(), c->requester());
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(RandomSinkTests, RepeatedRequestsTrade) {
+  // A constant sink requests the same (cached) material every timestep. It
+  // must be matched on each of them, with its mutual requests across two
+  // commodities filled only once per timestep, and again after timesteps
+  // without trades.
+  std::string config = 
+    "   <in_commods><val>leu</val><val>leu2</val></in_commods> "
+    "   <recipe_name>leu</recipe_name> "
+    "   <avg_qty>2</avg_qty> ";
+
+  int simdur = 6;
+  cyclus::MockSim sim(cyclus::AgentSpec
+		      (":mbmore:RandomSink"), config, simdur);
+  sim.AddRecipe("leu", c_leu());
+  sim.AddSource("leu")
+    .capacity(10)
+    .recipe("leu")
+    .Finalize();
+  sim.AddSource("leu2")
+    .capacity(10)
+    .recipe("leu")
+    .Finalize();
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("ReceiverId", "==", id));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(simdur, qr.rows.size());
+  std::vector<int> per_step(simdur, 0);
+  for (int it = 0; it < qr.rows.size(); it++) {
+    per_step[qr.GetVal<int>("Time", it)]++;
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", it));
+    EXPECT_DOUBLE_EQ(2, m->quantity());
+  }
+  for (int t = 0; t < simdur; t++) {
+    EXPECT_EQ(1, per_step[t]) << "timestep " << t;
+  }
+
+  // trading only on every other timestep, the material kept from the last
+  // trade is requested again after each gap
+  std::string every_config = config +
+    "   <social_behav>Every</social_behav> "
+    "   <behav_interval>2</behav_interval> ";
+  cyclus::MockSim every_sim(cyclus::AgentSpec
+			    (":mbmore:RandomSink"), every_config, simdur);
+  every_sim.AddRecipe("leu", c_leu());
+  every_sim.AddSource("leu")
+    .capacity(10)
+    .recipe("leu")
+    .Finalize();
+  int every_id = every_sim.Run();
+
+  std::vector<Cond> every_conds;
+  every_conds.push_back(Cond("ReceiverId", "==", every_id));
+  QueryResult every_qr = every_sim.db().Query("Transactions", &every_conds);
+  EXPECT_EQ(simdur/2, every_qr.rows.size());
+  for (int it = 0; it < every_qr.rows.size(); it++) {
+    Material::Ptr m = every_sim.GetMaterial(
+        every_qr.GetVal<int>("ResourceId", it));
+    EXPECT_DOUBLE_EQ(2, m->quantity());
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(RandomSinkTest, DISABLED_RequestCacheOverhead) {
+  // Benchmark (run with --gtest_also_run_disabled_tests) of the requests
+  // made by many sinks that each list many commodities and ask for the same
+  // amount every timestep, rebuilding the requested resources every time (as
+  // before caching) and reusing them. Times are reported as test
+  // properties.
+  int n_sinks = 200;
+  int n_commods = 50;
+  int n_timesteps = 20;
+  for (int i = 0; i < n_sinks; i++) {
+    SetRequest(NewSink(n_commods), 1.0, recipe);
+  }
+
+  typedef std::chrono::steady_clock clock;
+  clock::time_point start = clock::now();
+  for (int t = 0; t < n_timesteps; t++) {
+    for (int i = 0; i < n_sinks; i++) {
+      ClearRequestCache(sinks[i]);
+      sinks[i]->GetMatlRequests();
+      sinks[i]->GetGenRsrcRequests();
+    }
+  }
+  double rebuilt_us = std::chrono::duration<double, std::micro>(
+      clock::now() - start).count() / n_timesteps;
+
+  start = clock::now();
+  for (int t = 0; t < n_timesteps; t++) {
+    for (int i = 0; i < n_sinks; i++) {
+      sinks[i]->GetMatlRequests();
+      sinks[i]->GetGenRsrcRequests();
+    }
+  }
+  double cached_us = std::chrono::duration<double, std::micro>(
+      clock::now() - start).count() / n_timesteps;
+
+  RecordProperty("rebuilt_us_per_timestep", int(rebuilt_us));
+  RecordProperty("cached_us_per_timestep", int(cached_us));
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   /*
-    rng_seed: cannot be tested
     avg_qty: for normal dist (already tested in behavior fns)
     sigma: for normal dist (already tested in behavior fns)
   */
@@ -0,0 +1,38 @@
+#ifndef MBMORE_SRC_RANDOMSINK_TESTS_
+#define MBMORE_SRC_RANDOMSINK_TESTS_
+
+#include <gtest/gtest.h>
+
+#include "test_context.h"
+
+#include "RandomSink.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+class RandomSinkTest : public ::testing::Test {
+ protected:
+  cyclus::TestContext tc_;
+  cyclus::Composition::Ptr recipe;
+  std::vector<RandomSink*> sinks;
+
+  virtual void SetUp();
+  virtual void TearDown();
+  /// @param n_commods number of input commodities the sink requests
+  RandomSink* NewSink(int n_commods);
+  /// Set the amount and recipe a sink requests, as at the end of its Tick
+  void SetRequest(RandomSink* sink, double amt,
+                  cyclus::Composition::Ptr comp);
+  /// Add an input commodity to a sink
+  void AddCommod(RandomSink* sink, const std::string& commod);
+  /// Drop the cached request targets, so the next request is built from
+  /// scratch
+  void ClearRequestCache(RandomSink* sink);
+  /// Trade on multiples of interval, requesting qty each time
+  void SetEvery(RandomSink* sink, double interval, double qty);
+  /// Forget the drawn schedule, as an agent restored from a snapshot has
+  void DropSchedule(RandomSink* sink);
+};
+
+}  // namespace mbmore
+#endif  // MBMORE_SRC_RANDOMSINK_TESTS_
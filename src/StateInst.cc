@@ -2,13 +2,16 @@
 #include "StateInst.h"
 #include "InteractRegion.h"
 #include "behavior_functions.h"
+#include "perf_timers.h"
 #include <cmath>
 
 namespace mbmore {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 StateInst::StateInst(cyclus::Context* ctx)
-  : cyclus::Institution(ctx){
+  : cyclus::Institution(ctx),
+    conflict_id_(-1),
+    state_id_(-1) {
     //    kind("State"){
   cyclus::Warn<cyclus::EXPERIMENTAL_WARNING>("the StateInst agent is experimental.");
 }
@@ -28,6 +31,7 @@ void StateInst::DecomNotify(Agent* a) {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void StateInst::EnterNotify() {
   cyclus::Institution::EnterNotify();
+  rng_.Seed(rng_seed, id());
 
 
   //TODO: IS THIS NECESSARY?
@@ -52,6 +56,10 @@ void StateInst::Register_(Agent* a) {
   using cyclus::toolkit::CommodityProducer;
   using cyclus::toolkit::CommodityProducerManager;
 
+  if ((a->parent() == this) && IsSinkArchetype_(a->spec())) {
+    child_sinks_.insert(a);
+  }
+
   CommodityProducer* cp_cast = dynamic_cast<CommodityProducer*>(a);
   //  if (cp_cast != NULL) {
     LOG(cyclus::LEV_INFO3, "mani") << "Registering agent "
@@ -66,12 +74,34 @@ void StateInst::Unregister_(Agent* a) {
   using cyclus::toolkit::CommodityProducer;
   using cyclus::toolkit::CommodityProducerManager;
 
+  child_sinks_.erase(a);
+
   CommodityProducer* cp_cast = dynamic_cast<CommodityProducer*>(a);
   if (cp_cast != NULL)
     CommodityProducerManager::Unregister(cp_cast);
 }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool StateInst::IsSinkArchetype_(const std::string& spec) {
+  size_t pos = spec.rfind(':');
+  if (pos == std::string::npos) {
+    return false;
+  }
+  return (spec.compare(pos, std::string::npos, ":Sink") == 0) ||
+    (spec.compare(pos, std::string::npos, ":RandomSink") == 0);
+}
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void StateInst::Tick() {
+  MBMORE_PERF_TICK("StateInst", context());
+
+  // Resolve this state's handle into the region's tables once, so that
+  // decisions do not look up the state by name
+  if (state_id_ < 0){
+    Agent* me = this;
+    InteractRegion* pseudo_region =
+      dynamic_cast<InteractRegion*>(this->parent());
+    state_id_ = pseudo_region->StateId(me->prototype());
+  }
 
   // Things to do only at beginning of Simulation
   if (context()->time() == 0){
@@ -83,12 +113,9 @@ void StateInst::Tick() {
     }
     
     //Record initial weapon status
-    Agent* me = this;
-    std::string proto = me->prototype();
-
     InteractRegion* pseudo_region =
       dynamic_cast<InteractRegion*>(this->parent());
-    pseudo_region->UpdateWeaponStatus(proto, weapon_status);
+    pseudo_region->UpdateWeaponStatus(state_id_, weapon_status);
 
     // If starting status is 'pursuing' or 'acquired', create the secret sink
     // at simulation start
@@ -110,7 +137,7 @@ void StateInst::Tick() {
 	  && (constants.size() == 2)){
 	double y0 = constants[0];
 	double yf = constants[1];
-	int t_change = RNG_Integer(0, simdur, rng_seed);
+	int t_change = RNG_Integer(0, simdur, rng_);
 	// add the t_change to the P_f record
 	eqn_it->second.second.push_back(t_change);
       }
@@ -121,7 +148,7 @@ void StateInst::Tick() {
 	  && (constants.size() == 1)){
 	double yf = constants[0];
 	if (std::abs(yf) <= 1){
-	  int t_change = RNG_Integer(0, simdur, rng_seed);
+	  int t_change = RNG_Integer(0, simdur, rng_);
 	  eqn_it->second.second.push_back(t_change);
 	}
       }
@@ -130,72 +157,175 @@ void StateInst::Tick() {
 }
   
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Weapon decisions for all states are made together by the parent
+// InteractRegion in its Tock (see InteractRegion::DecideStates_)
 void StateInst::Tock() {
+  MBMORE_PERF_TOCK("StateInst", context());
   // TODO:: How to force SecretEnrich to trade Only with SecretSink??
+}
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::string StateInst::DecisionPhase() const {
+  if (weapon_status == 0) {
+    return "Pursuit";
+  }
+  else if (weapon_status == 2) {
+    return "Acquire";
+  }
+  return "";
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Pursuit (if detected) and acquire each change the conflict map
+void StateInst::ApplyDecision(const DecisionResult& result) {
   InteractRegion* pseudo_region =
     dynamic_cast<InteractRegion*>(this->parent());
+  std::vector<std::string>& master_factors = pseudo_region->GetMasterFactors();
+
+  if (pseudo_region->SparseProgress()) {
+    RecordSparseProgress_(result, pseudo_region);
+  }
+  else {
+    cyclus::Datum *d = context()->NewDatum("WeaponProgress");
+    d->AddVal("Time", context()->time());
+    d->AddVal("AgentId", cyclus::Agent::id());
+    d->AddVal("EqnType", result.eqn_type);
+    for (int f = 0; f < result.factor_vals.size(); f++) {
+      d->AddVal(master_factors[f].c_str(), result.factor_vals[f]);
+    }
+    d->AddVal("EqnVal", result.eqn_val);
+    d->AddVal("Likelihood", result.likely);
+    d->AddVal("Decision", result.decision);
+    d->Record();
+  }
+
+  if ((result.likely < 0) || (result.likely > 1)){
+    std::stringstream ss;
+    ss << "likelihood of weapon decision isnt between 0-1!"
+       << "Something went wrong!";
+    cyclus::Warn<cyclus::VALUE_WARNING>(ss.str());
+  }
+
   Agent* me = this;
   std::string proto = me->prototype();
-  // Pursuit (if detected) and acquire each change the conflict map
+  // Conflict changes are not seen by any state until the NEXT timestep
+  if (result.change_relation) {
+    // TODO: THIS SHOULD BE eqn_Type not PURSUIT (but doesn't really matteR)
+    pseudo_region->ChangeConflictReln("Pursuit", proto,
+				      result.relation_state,
+				      result.relation_val);
+  }
+
+  if (!result.decision) {
+    return;
+  }
   if (weapon_status == 0) {
-    std::string eqn_type = "Pursuit";
-    bool pursuit_decision = WeaponDecision(eqn_type);
-    if (pursuit_decision == 1) {
-      LOG(cyclus::LEV_INFO2, "StateInst") << "StateInst " << this->id()
-					  << " is deploying a HEUSink at:" 
-					  << context()->time() << ".";
-      DeploySecret();
-      weapon_status = 2;
-      pseudo_region->UpdateWeaponStatus(proto, weapon_status);
-    }
+    LOG(cyclus::LEV_INFO2, "StateInst") << "StateInst " << this->id()
+					<< " is deploying a HEUSink at:" 
+					<< context()->time() << ".";
+    DeploySecret();
+    weapon_status = 2;
+    pseudo_region->UpdateWeaponStatus(state_id_, weapon_status);
   }
   // If state is pursuing but hasn't yet acquired
   else if (weapon_status == 2) {
-    std::string eqn_type = "Acquire";
-    //    std::string eqn_type = "Pu";
-    bool acquire_decision = WeaponDecision(eqn_type);
     // State now successfully acquires
-    if (acquire_decision == 1) {
-      weapon_status = 3;
-      pseudo_region->UpdateWeaponStatus(proto, weapon_status);
-      LOG(cyclus::LEV_INFO2, "StateInst") << "StateInst " << this->id()
-					  << " is producing weapons at: " 
-					  << context()->time() << ".";
+    weapon_status = 3;
+    pseudo_region->UpdateWeaponStatus(state_id_, weapon_status);
+    LOG(cyclus::LEV_INFO2, "StateInst") << "StateInst " << this->id()
+					<< " is producing weapons at: " 
+					<< context()->time() << ".";
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A factor's value at any time is that of its latest WeaponFactorChanges row
+// at or before that time. Factors that are not defined in the sim are listed
+// in UndefinedFactors with the first record instead, and are never written.
+void StateInst::RecordSparseProgress_(const DecisionResult& result,
+				      InteractRegion* pseudo_region) {
+  std::vector<std::string>& master_factors = pseudo_region->GetMasterFactors();
+  const FactorSet& present = pseudo_region->GetPresentFactors("Pursuit");
+  int agent_id = cyclus::Agent::id();
+  int cur_time = context()->time();
+
+  bool first_record = recorded_factor_vals_.empty();
+  if (first_record) {
+    for (int f = 0; f < master_factors.size(); f++) {
+      if (!present[f]) {
+	context()->NewDatum("UndefinedFactors")
+	  ->AddVal("AgentId", agent_id)
+	  ->AddVal("Factor", master_factors[f])
+	  ->Record();
+      }
     }
+    recorded_factor_vals_.assign(result.factor_vals.size(), 0.0);
   }
+
+  for (int f = 0; f < result.factor_vals.size(); f++) {
+    if (!present[f]) {
+      continue;
+    }
+    if (first_record || (result.factor_vals[f] != recorded_factor_vals_[f])) {
+      context()->NewDatum("WeaponFactorChanges")
+	->AddVal("Time", cur_time)
+	->AddVal("AgentId", agent_id)
+	->AddVal("Factor", master_factors[f])
+	->AddVal("Value", result.factor_vals[f])
+	->Record();
+      recorded_factor_vals_[f] = result.factor_vals[f];
+    }
+  }
+
+  context()->NewDatum("WeaponProgress")
+    ->AddVal("Time", cur_time)
+    ->AddVal("AgentId", agent_id)
+    ->AddVal("EqnType", result.eqn_type)
+    ->AddVal("EqnVal", result.eqn_val)
+    ->AddVal("Likelihood", result.likely)
+    ->AddVal("Decision", result.decision)
+    ->Record();
 }
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // State inst disallows any trading from SecretSink or SecretEnrich when
 // until acquired = 1.
 void StateInst::AdjustMatlPrefs(
   cyclus::PrefMap<cyclus::Material>::type& prefs) {
+  MBMORE_PERF_SCOPE("StateInst", "AdjustMatlPrefs");
 
   using cyclus::Bid;
   using cyclus::Material;
   using cyclus::Request;
 
+  // Only requests from my own (secret) sinks are adjusted
+  if (child_sinks_.empty()) {
+    return;
+  }
+
+  // The exchange passes the requests of one trader at a time, so the
+  // requester rarely changes within the map
+  Agent* last_requester = NULL;
+  bool is_child_sink = false;
   cyclus::PrefMap<cyclus::Material>::type::iterator pmit;
   for (pmit = prefs.begin(); pmit != prefs.end(); ++pmit) {
+    Agent* you = pmit->first->requester()->manager();
+    if (you != last_requester) {
+      last_requester = you;
+      is_child_sink = (child_sinks_.count(you) > 0);
+    }
+    if (!is_child_sink) {
+      continue;
+    }
     std::map<Bid<Material>*, double>::iterator mit;
-    Request<Material>* req = pmit->first;
-    Agent* you = req->requester()->manager();
-    Agent* me = this;
-      // If you are my child (then you're secret),
-      // and you're a type of Sink, then adjust preferences
-      std::string full_name = you->spec();
-      std::string archetype = full_name.substr(full_name.rfind(':'));
-      if ((you->parent()->id() == me->id()) &&
-	  ((archetype == ":Sink") || (archetype == ":RandomSink"))){
-	for (mit = pmit->second.begin(); mit != pmit->second.end(); ++mit) {
-	  if (weapon_status == 3){
-	    mit->second += 1; 
-	  }
-	  else {
-	    mit->second = -1;
-	  }
-	}
+    for (mit = pmit->second.begin(); mit != pmit->second.end(); ++mit) {
+      if (weapon_status == 3){
+	mit->second += 1; 
+      }
+      else {
+	mit->second = -1;
       }
+    }
   }
 }
 
@@ -211,101 +341,117 @@ void StateInst::DeploySecret() {
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Build the flat per-factor equations used by WeaponDecision. Factor ids are
+// positions in the region's master factor list, so every string lookup
+// happens here once instead of once per factor per timestep. (Weights and
+// defined factors are shared by the region's factor registry)
+void StateInst::InternFactors_(InteractRegion* pseudo_region) {
+  std::vector<std::string>& master_factors = pseudo_region->GetMasterFactors();
+
+  int n_factors = master_factors.size();
+  factor_eqns_.assign(n_factors, FactorEqn());
+  conflict_id_ = -1;
+
+  std::map<std::string,
+	   std::pair<std::string, std::vector<double> > >::const_iterator pf_it;
+  for (int f = 0; f < n_factors; f++) {
+    const std::string& factor = master_factors[f];
+    FactorEqn& eqn = factor_eqns_[f];
+    pf_it = P_f.find(factor);
+    if (pf_it != P_f.end()) {
+      eqn.relation = pf_it->second.first;
+      eqn.constants = pf_it->second.second;
+    }
+    eqn.function = ParseYValFunction(eqn.relation);
+    if (factor == "Conflict") {
+      conflict_id_ = f;
+    }
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // At each timestep where pursuit has not yet occurred, calculate whether to
 // pursue at this time step.
-  bool StateInst::WeaponDecision(std::string eqn_type) {
-  using cyclus::Context;
-  using cyclus::Agent;
-  using cyclus::Recorder;
-  cyclus::Datum *d = context()->NewDatum("WeaponProgress");
-  d->AddVal("Time", context()->time());
-  d->AddVal("AgentId", cyclus::Agent::id());
-  d->AddVal("EqnType", eqn_type);
-
-  std::map <std::string, double> P_wt;
-  std::map <std::string, double> P_factors;
-
+void StateInst::EvaluateDecision(std::string eqn_type,
+				 DecisionResult* result) {
+  MBMORE_PERF_SCOPE("StateInst", "EvaluateDecision");
   // Make a pointer to my parent region so I can access the RegionLevel
   // variables (in a similar way to how the Context provides simulation
   // level information)
   InteractRegion* pseudo_region =
     dynamic_cast<InteractRegion*>(this->parent());
-  
-  // All defined factors should be recorded with their actual value
-  P_wt = pseudo_region->GetWeights("Pursuit");
+
   // Even if state is already pursuing and working toward acquire, the success
   // rate is determined by the value of the pursuit factors, so score must be
   // calculated
-  
+  if (factor_eqns_.empty()) {
+    InternFactors_(pseudo_region);
+  }
+
+  // All defined factors should be recorded with their actual value
+  const std::vector<double>& P_wt = pseudo_region->GetFactorWeights("Pursuit");
+
   // Any factors not defined for sim should have a value of zero in the table
-  std::vector<std::string>& master_factors = pseudo_region->GetMasterFactors();
-  std::map<std::string, bool> present = pseudo_region->DefinedFactors("Pursuit");
+  const FactorSet& present = pseudo_region->GetPresentFactors("Pursuit");
+  int n_states = pseudo_region->GetNStates();
+  int cur_time = context()->time();
 
+  result->eqn_type = eqn_type;
+  result->factor_vals.assign(factor_eqns_.size(), 0.0);
+  result->change_relation = false;
   double pursuit_eqn = 0;
 
   // Iterate through master list of factors. If not present then record 0
   // in database. If present then calculate current value based on time
   // dynamics
-  for(int f = 0; f < master_factors.size(); f++){
-    const std::string& factor = master_factors[f];
-    bool f_defined  = present[std::string(factor)];
-    // for most factors 'relation' defines the function for time dynamics of
-    // the factor. But for Conflict, 'relation' is the pair state in the
-    // relationship
-    std::string relation = P_f[factor].first;
-    std::vector<double> constants =  P_f[factor].second;
-
-    // Record zeroes for any columns not defined in input file
-    if (!f_defined) {
-      d->AddVal(factor.c_str(), 0.0);
+  for(int f = 0; f < factor_eqns_.size(); f++){
+    if (!present[f]) {
+      continue;
     }
-    else {
-      double factor_curr_y;
-      // Determine the State's conflict score for this timestep
-      int n_states = pseudo_region->GetNStates();
-      if (factor == "Conflict"){
-	if (n_states <= 1){
-	  factor_curr_y = 0;
-	}
-	else{
-	  Agent* me = this;
-	  std::string proto = me->prototype();
-	  factor_curr_y =
-	    pseudo_region->GetConflictScore("Pursuit", proto);
-	  // Then check conflict value to see if it needs to change. If
-	  //constants is a single element then it doesn't have a time-based
-	  // change. This change is not propogated until the NEXT timestep
-	  // This is done last because changing conflict for one state will
-	  // also affect another state whose score for this timestep may have
-	  // already been calculated.
-	  if ((constants.size() > 1) && (constants[1] == context()->time())){
-	    int new_val = std::round(constants[0]);
-	    // TODO: THIS SHOULD BE eqn_Type not PURSUIT (but doesn't really matteR)
-	    pseudo_region->ChangeConflictReln("Pursuit", proto,
-				      relation, new_val); 
-	  }
-	}
+
+    const FactorEqn& eqn = factor_eqns_[f];
+    double factor_curr_y;
+    // Determine the State's conflict score for this timestep
+    if (f == conflict_id_){
+      if (n_states <= 1){
+	factor_curr_y = 0;
       }
-      else {
-	factor_curr_y = CalcYVal(relation, constants,context()->time());
+      else{
+	factor_curr_y =
+	  pseudo_region->GetConflictScore("Pursuit", state_id_);
+	// Then check conflict value to see if it needs to change. If
+	//constants is a single element then it doesn't have a time-based
+	// change. The change is applied with the decision, after every
+	// state's score for this timestep has been calculated.
+	if ((eqn.constants.size() > 1) && (eqn.constants[1] == cur_time)){
+	  result->change_relation = true;
+	  result->relation_state = eqn.relation;
+	  result->relation_val = std::round(eqn.constants[0]);
+	}
       }
-      pursuit_eqn += (factor_curr_y * P_wt[factor]);
-      P_factors[factor] = factor_curr_y;
-      d->AddVal(factor.c_str(), factor_curr_y);
     }
+    else {
+      factor_curr_y = CalcYVal(eqn.function, eqn.constants, cur_time);
+    }
+    pursuit_eqn += (factor_curr_y * P_wt[f]);
+    result->factor_vals[f] = factor_curr_y;
   }
   // Convert pursuit eqn result to a Y/N decision
-  // GetLikely requires an input value between 0-10, and the function type
+  // CalcLikely requires an input value between 0-10, and the function type
   // should be normalized to convert that value to have a max of y=1.0 for x=10
-  double likely = pseudo_region->GetLikely(eqn_type, pursuit_eqn);
-  bool decision = XLikely(likely, rng_seed);
-
-  d->AddVal("EqnVal", pursuit_eqn);
-  d->AddVal("Likelihood", likely);
-  d->AddVal("Decision", decision);
-  d->Record();
-  return decision;  
+  result->eqn_val = pursuit_eqn;
+  result->likely = pseudo_region->CalcLikely(eqn_type, pursuit_eqn);
+  result->decision = XLikely(result->likely, rng_);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool StateInst::WeaponDecision(std::string eqn_type) {
+  MBMORE_PERF_SCOPE("StateInst", "WeaponDecision");
+  DecisionResult result;
+  EvaluateDecision(eqn_type, &result);
+  ApplyDecision(result);
+  return result.decision;
 }
   
 
@@ -1,10 +1,15 @@
 #ifndef MBMORE_SRC_STATE_INST_H_
 #define MBMORE_SRC_STATE_INST_H_
 
+#include <unordered_set>
+
 #include "cyclus.h"
+#include "behavior_functions.h"
 
 namespace mbmore {
 
+class InteractRegion;
+
 typedef std::map<int, std::vector<std::string> > BuildSched;
   
 /// @class StateInst
@@ -47,8 +52,34 @@ class StateInst
   virtual void DeploySecret();
 
 
+  // Outcome of one state's weapon decision for a timestep, including the
+  // values to be recorded and any conflict relation change it triggers.
+  struct DecisionResult {
+    std::string eqn_type;
+    std::vector<double> factor_vals;
+    double eqn_val;
+    double likely;
+    bool decision;
+    bool change_relation;
+    std::string relation_state;
+    int relation_val;
+  };
+
+  // Pursuit while not pursuing, Acquire while pursuing, otherwise no
+  // decision is made this timestep (empty string)
+  std::string DecisionPhase() const;
+
   // Do calculation of pursuit equation and convert to a Y/N on whether to
-  // start pursuing a weapon at each timestep.
+  // start pursuing a weapon at each timestep. Only reads the region and
+  // context and draws from this state's own RNG stream, so different states
+  // can be evaluated concurrently.
+  void EvaluateDecision(std::string eqn_type, DecisionResult* result);
+
+  // Record the decision and apply its status and relation changes. Must be
+  // called serially, in state order.
+  void ApplyDecision(const DecisionResult& result);
+
+  // Evaluate and apply a decision for this state alone
   bool WeaponDecision(std::string eqn_type);
 
   virtual void Tick();
@@ -75,6 +106,51 @@ class StateInst
   /// unregister a child
   void Unregister_(cyclus::Agent* agent);
 
+  // Whether an agent's archetype (the last part of its spec) is Sink or
+  // RandomSink, the archetypes that secret material is requested through
+  static bool IsSinkArchetype_(const std::string& spec);
+
+  // Write this decision's WeaponProgress row, and the factors that changed
+  // since the last one to WeaponFactorChanges (sparse_progress mode)
+  void RecordSparseProgress_(const DecisionResult& result,
+			     InteractRegion* pseudo_region);
+
+  // Resolve the master factor list of the region into integer ids (position
+  // in InteractRegion::column_names) and fill factor_eqns_ from P_f.
+  // Done once, on the first decision.
+  void InternFactors_(InteractRegion* pseudo_region);
+
+  // Pursuit factor time dynamics, indexed by factor id. For most factors
+  // 'relation' is the function name (already parsed into 'function'), but
+  // for Conflict it is the pair state in the relationship.
+  struct FactorEqn {
+    YValFunction function;
+    std::string relation;
+    std::vector<double> constants;
+  };
+  std::vector<FactorEqn> factor_eqns_;
+
+  // Factor id of Conflict, which is scored by the region (-1 if not a master
+  // factor)
+  int conflict_id_;
+
+  // Random stream for the factor change times and weapon decisions, seeded
+  // from rng_seed and agent id
+  RNGStream rng_;
+
+  // This state's id in the region's status and conflict tables (-1 until
+  // resolved in the first Tick)
+  int state_id_;
+
+  // Factor values in the last sparse WeaponProgress record, by factor id
+  // (empty until the first record)
+  std::vector<double> recorded_factor_vals_;
+
+  // Children whose archetype is a sink, added and removed as they are built
+  // and decommissioned, so that preference adjustment can skip requests from
+  // any other agent with a single lookup
+  std::unordered_set<cyclus::Agent*> child_sinks_;
+
   // Find the simulation duration
   //  cyclus::SimInfo si_;
   int simdur = context()->sim_info().duration;
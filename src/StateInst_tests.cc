@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 
 #include "cyclus.h"
+#include "test_context.h"
+
+#include "StateInst.h"
+#include "alloc_counter_tests.h"
 
 namespace mbmore {
 
@@ -41,8 +45,35 @@ namespace StateInstTests {
 }
   */
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Preferences of traders that are not one of the state's sinks are left
+// alone, without allocating
+TEST(StateInstTests, AdjustPrefsAllocations) {
+  using cyclus::Bid;
+  using cyclus::Material;
+  using cyclus::Request;
 
+  cyclus::TestContext tc;
+  StateInst* state = new StateInst(tc.get());
+  cyclus::CompMap v;
+  v[922350000] = 0.04;
+  v[922380000] = 0.96;
+  Material::Ptr mat =
+      Material::CreateUntracked(1, cyclus::Composition::CreateFromMass(v));
+  Request<Material>* req = Request<Material>::Create(mat, tc.trader(), "leu");
+  Bid<Material>* bid = Bid<Material>::Create(req, mat, tc.trader());
+  cyclus::PrefMap<Material>::type prefs;
+  prefs[req][bid] = 1;
 
+  state->AdjustMatlPrefs(prefs);
+  AllocCounter allocs;
+  state->AdjustMatlPrefs(prefs);
+  allocs.Stop();
+  ReportAllocs("AdjustMatlPrefs", allocs);
+  EXPECT_EQ(0, allocs.count());
+  EXPECT_EQ(1, prefs[req][bid]);
+  delete state;
+}
 
 } // namespace StateInstTests
 } // namespace mbmore
\ No newline at end of file
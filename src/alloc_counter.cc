@@ -0,0 +1,54 @@
+// Implements the AllocCounter class
+#include "alloc_counter.h"
+
+namespace mbmore {
+
+// allocations made by each thread since it started
+static thread_local long long thread_count = 0;
+static thread_local long long thread_bytes = 0;
+static bool hook_enabled = false;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+AllocCounter::AllocCounter()
+    : start_count_(thread_count),
+      start_bytes_(thread_bytes),
+      stop_count_(0),
+      stop_bytes_(0),
+      running_(true) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AllocCounter::Stop() {
+  if (running_) {
+    stop_count_ = thread_count;
+    stop_bytes_ = thread_bytes;
+    running_ = false;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+long long AllocCounter::count() const {
+  return (running_ ? thread_count : stop_count_) - start_count_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+long long AllocCounter::bytes() const {
+  return (running_ ? thread_bytes : stop_bytes_) - start_bytes_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AllocCounter::Count(std::size_t bytes) {
+  thread_count++;
+  thread_bytes += bytes;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AllocCounter::Enable() {
+  hook_enabled = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool AllocCounter::Enabled() {
+  return hook_enabled;
+}
+
+}  // namespace mbmore
@@ -0,0 +1,52 @@
+#ifndef MBMORE_SRC_ALLOC_COUNTER_H_
+#define MBMORE_SRC_ALLOC_COUNTER_H_
+
+#include <cstddef>
+
+namespace mbmore {
+
+// Heap allocations made by the calling thread while a counter is running,
+// for measuring (and asserting on) the allocations of an agent phase:
+//   AllocCounter allocs;
+//   facility->GetMatlBids(requests);
+//   allocs.Stop();
+//   EXPECT_EQ(0, allocs.count());
+//
+// The library never replaces the allocator. Allocations are only seen in a
+// binary whose global operator new calls AllocCounter::Count and then
+// AllocCounter::Enable, as the unit tests do (see alloc_counter_tests.cc).
+// Everywhere else the counts stay at 0 and Enabled() is false.
+class AllocCounter {
+ public:
+  // Start counting
+  AllocCounter();
+
+  // Stop counting. count() and bytes() keep their values afterwards.
+  void Stop();
+
+  // Number and total size of the allocations made since construction (or
+  // until Stop)
+  long long count() const;
+  long long bytes() const;
+
+  // Allocation hook, called by the replaced operator new with the size of
+  // every allocation
+  static void Count(std::size_t bytes);
+
+  // Marks the hook as installed
+  static void Enable();
+
+  // True if the running binary feeds allocations to the counters
+  static bool Enabled();
+
+ private:
+  long long start_count_;
+  long long start_bytes_;
+  long long stop_count_;
+  long long stop_bytes_;
+  bool running_;
+};
+
+}  // namespace mbmore
+
+#endif  // MBMORE_SRC_ALLOC_COUNTER_H_
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter_tests.h"
+
+// The unit test binary replaces the global allocator so that every
+// allocation, in mbmore or in cyclus, is seen by the AllocCounters
+void* operator new(std::size_t size) {
+  mbmore::AllocCounter::Count(size);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  mbmore::AllocCounter::Count(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+namespace mbmore {
+
+static const bool alloc_hook_enabled = (AllocCounter::Enable(), true);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ReportAllocs(const std::string& phase, const AllocCounter& allocs) {
+  ::testing::Test::RecordProperty(phase + "_allocs",
+                                  static_cast<int>(allocs.count()));
+  ::testing::Test::RecordProperty(phase + "_bytes",
+                                  static_cast<int>(allocs.bytes()));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ReportPhaseAllocs(cyclus::Facility* fac, cyclus::Trader* requester,
+                       const std::string& commod,
+                       cyclus::Material::Ptr target) {
+  using cyclus::Bid;
+  using cyclus::Material;
+  using cyclus::Request;
+  using cyclus::Trade;
+
+  Request<Material>* req = Request<Material>::Create(target, requester, commod);
+  cyclus::CommodMap<Material>::type requests;
+  requests[commod].push_back(req);
+
+  fac->Tick();
+  fac->GetMatlRequests();
+  fac->GetMatlBids(requests);
+
+  AllocCounter tick;
+  fac->Tick();
+  tick.Stop();
+  ReportAllocs("Tick", tick);
+
+  AllocCounter requests_allocs;
+  fac->GetMatlRequests();
+  requests_allocs.Stop();
+  ReportAllocs("GetMatlRequests", requests_allocs);
+
+  AllocCounter bids;
+  fac->GetMatlBids(requests);
+  bids.Stop();
+  ReportAllocs("GetMatlBids", bids);
+
+  AllocCounter bids_again;
+  fac->GetMatlBids(requests);
+  bids_again.Stop();
+  EXPECT_EQ(bids.count(), bids_again.count());
+
+  Bid<Material>* bid = Bid<Material>::Create(req, target, fac);
+  std::vector<Trade<Material> > trades;
+  trades.push_back(Trade<Material>(req, bid, 0.1));
+  std::vector<std::pair<Trade<Material>, Material::Ptr> > responses;
+  AllocCounter trade;
+  fac->GetMatlTrades(trades, responses);
+  trade.Stop();
+  ASSERT_EQ(1, responses.size());
+  ReportAllocs("GetMatlTrades", trade);
+
+  AllocCounter tock;
+  fac->Tock();
+  tock.Stop();
+  ReportAllocs("Tock", tock);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AllocCounterTest, HookInstalled) {
+  EXPECT_TRUE(alloc_hook_enabled);
+  EXPECT_TRUE(AllocCounter::Enabled());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Counters see the allocations made while they run, and keep their values
+// once stopped
+TEST(AllocCounterTest, CountsAllocations) {
+  AllocCounter allocs;
+  EXPECT_EQ(0, allocs.count());
+
+  void* a = ::operator new(64);
+  void* b = ::operator new[](16);
+  EXPECT_EQ(2, allocs.count());
+  EXPECT_EQ(80, allocs.bytes());
+
+  allocs.Stop();
+  void* c = ::operator new(8);
+  EXPECT_EQ(2, allocs.count());
+  EXPECT_EQ(80, allocs.bytes());
+
+  ::operator delete(a);
+  ::operator delete[](b);
+  ::operator delete(c);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// An inner counter only sees its own part of the outer one
+TEST(AllocCounterTest, NestedCounters) {
+  AllocCounter outer;
+  void* a = ::operator new(32);
+  {
+    AllocCounter inner;
+    void* b = ::operator new(32);
+    inner.Stop();
+    EXPECT_EQ(1, inner.count());
+    ::operator delete(b);
+  }
+  outer.Stop();
+  EXPECT_EQ(2, outer.count());
+  EXPECT_EQ(64, outer.bytes());
+  ::operator delete(a);
+}
+
+}  // namespace mbmore
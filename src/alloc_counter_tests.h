@@ -0,0 +1,28 @@
+#ifndef MBMORE_SRC_ALLOC_COUNTER_TESTS_
+#define MBMORE_SRC_ALLOC_COUNTER_TESTS_
+
+#include <string>
+
+#include "cyclus.h"
+
+#include "alloc_counter.h"
+
+namespace mbmore {
+
+/// Adds the allocations of an agent phase to the test properties
+/// (<phase>_allocs and <phase>_bytes), so that they can be compared between
+/// commits
+void ReportAllocs(const std::string& phase, const AllocCounter& allocs);
+
+/// Reports the allocations of each timestep phase of a facility that sells
+/// target on commod to requester. Each phase is called once beforehand so
+/// that only steady-state allocations are counted, and bidding twice on the
+/// same requests must allocate the same amount both times. The facility
+/// must be able to trade before this is called.
+void ReportPhaseAllocs(cyclus::Facility* fac, cyclus::Trader* requester,
+                       const std::string& commod,
+                       cyclus::Material::Ptr target);
+
+}  // namespace mbmore
+
+#endif  // MBMORE_SRC_ALLOC_COUNTER_TESTS_
@@ -2,7 +2,9 @@
 #include <ctime> // to make truly random
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 
 bool seeded;
 namespace mbmore {
@@ -81,6 +83,260 @@ bool EveryRandomXTimestep(int frequency, int rng_seed) {
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RNGStream::RNGStream() {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RNGStream::Seed(int rng_seed, int stream_id) {
+  unsigned int base_seed = (rng_seed == -1) ? time(0) : rng_seed;
+  std::seed_seq seq = {base_seed, static_cast<unsigned int>(stream_id)};
+  engine_.seed(seq);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RNGStream::Uniform() {
+  return std::generate_canonical<double, 53>(engine_);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Ziggurat tables for the normal distribution with 128 layers: kn are the
+// integer thresholds below which a sample is inside its layer, wn the scale
+// from integer to deviate, fn the density at each layer edge.
+struct ZigguratTables {
+  uint32_t kn[128];
+  double wn[128];
+  double fn[128];
+
+  ZigguratTables() {
+    const double m1 = 2147483648.0;
+    const double vn = 9.91256303526217e-3;
+    double dn = 3.442619855899;
+    double tn = dn;
+    double q = vn/std::exp(-0.5*dn*dn);
+
+    kn[0] = static_cast<uint32_t>((dn/q)*m1);
+    kn[1] = 0;
+    wn[0] = q/m1;
+    wn[127] = dn/m1;
+    fn[0] = 1.0;
+    fn[127] = std::exp(-0.5*dn*dn);
+    for (int i = 126; i >= 1; i--) {
+      dn = std::sqrt(-2.0*std::log(vn/dn + std::exp(-0.5*dn*dn)));
+      kn[i + 1] = static_cast<uint32_t>((dn/tn)*m1);
+      tn = dn;
+      fn[i] = std::exp(-0.5*dn*dn);
+      wn[i] = dn/m1;
+    }
+  }
+};
+
+static const ZigguratTables& Ziggurat() {
+  static const ZigguratTables tables;
+  return tables;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RNGStream::Normal() {
+  const double r = 3.442620;   // start of the tail
+  const ZigguratTables& z = Ziggurat();
+
+  for (;;) {
+    int32_t hz = static_cast<int32_t>(engine_());
+    int iz = hz & 127;
+    uint32_t abs_hz = (hz < 0) ? (0u - static_cast<uint32_t>(hz)) : hz;
+    double x = hz*z.wn[iz];
+    if (abs_hz < z.kn[iz]) {
+      return x;
+    }
+    if (iz == 0) {
+      // sample from the tail beyond r
+      double y;
+      do {
+	x = -std::log(1.0 - Uniform())/r;
+	y = -std::log(1.0 - Uniform());
+      } while (y + y < x*x);
+      return (hz > 0) ? (r + x) : -(r + x);
+    }
+    // wedge between the layer and the density
+    if (z.fn[iz] + Uniform()*(z.fn[iz - 1] - z.fn[iz]) <
+	std::exp(-0.5*x*x)) {
+      return x;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RNGStream::FillNormal(double mean, double sigma, double* out, int n) {
+  for (int i = 0; i < n; i++) {
+    out[i] = mean + sigma*Normal();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool XLikely(double prob, RNGStream& rng) {
+  return rng.Uniform() < prob;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RNG_NormalDist(double mean, double sigma, RNGStream& rng) {
+  if (sigma == 0) {
+    return mean;
+  }
+  return mean + sigma*rng.Normal();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Standard normal restricted to [a, b] with a < b. Proposals follow Robert
+// (1995): plain normal draws when the interval covers most of the mass around
+// zero, a translated exponential in a one-sided tail, and a uniform over
+// [a, b] when the interval is narrow.
+static double TruncStdNormal(double a, double b, RNGStream& rng) {
+  if (b <= 0) {
+    return -TruncStdNormal(-b, -a, rng);
+  }
+  double z;
+  if (a < 0) {
+    if (b - a >= std::sqrt(2.0*M_PI)) {
+      do {
+	z = rng.Normal();
+      } while ((z < a) || (z > b));
+      return z;
+    }
+    do {
+      z = a + (b - a)*rng.Uniform();
+    } while (rng.Uniform() >= std::exp(-0.5*z*z));
+    return z;
+  }
+
+  // 0 <= a < b
+  double root = std::sqrt(a*a + 4.0);
+  double alpha = 0.5*(a + root);
+  double uniform_width = (2.0/(a + root))*
+    std::exp(0.25*(a*a - a*root) + 0.5);
+  if (b - a < uniform_width) {
+    do {
+      z = a + (b - a)*rng.Uniform();
+    } while (rng.Uniform() >= std::exp(0.5*(a*a - z*z)));
+    return z;
+  }
+  do {
+    z = a - std::log(1.0 - rng.Uniform())/alpha;
+  } while ((z > b) ||
+	   (rng.Uniform() >= std::exp(-0.5*(z - alpha)*(z - alpha))));
+  return z;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double RNG_TruncNormal(double mean, double sigma, double lower, double upper,
+		       RNGStream& rng) {
+  if ((sigma <= 0) || (upper <= lower)) {
+    return std::min(std::max(mean, lower), upper);
+  }
+  return mean + sigma*TruncStdNormal((lower - mean)/sigma,
+				     (upper - mean)/sigma, rng);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int RNG_Integer(int min, int max, RNGStream& rng) {
+  if (max - min <= 1) {
+    return min;
+  }
+  std::uniform_int_distribution<int> dist(min, max - 1);
+  return dist(rng.engine());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int RNG_Binomial(int n_trials, double prob, RNGStream& rng) {
+  if ((n_trials <= 0) || (prob <= 0)) {
+    return 0;
+  }
+  if (prob >= 1) {
+    return n_trials;
+  }
+  std::binomial_distribution<int> dist(n_trials, prob);
+  return dist(rng.engine());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Columns are scaled so that the average weight is 1, then each column below
+// 1 is topped up from a column above 1, which becomes its alias.
+void AliasTable::Build(const std::vector<double>& weights) {
+  int n = weights.size();
+  prob_.assign(n, 1.0);
+  alias_.resize(n);
+  for (int i = 0; i < n; i++) {
+    alias_[i] = i;
+  }
+
+  double total = 0;
+  for (int i = 0; i < n; i++) {
+    total += weights[i];
+  }
+  if (total <= 0) {
+    return;
+  }
+
+  std::vector<double> scaled(n);
+  std::vector<int> small;
+  std::vector<int> large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = weights[i]*n/total;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    }
+    else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    int l = large.back();
+    small.pop_back();
+    large.pop_back();
+    prob_[s] = scaled[s];
+    alias_[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) {
+      small.push_back(l);
+    }
+    else {
+      large.push_back(l);
+    }
+  }
+  // anything left over is 1 to within round-off
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+int AliasTable::Sample(RNGStream& rng) const {
+  int n = prob_.size();
+  double u = rng.Uniform()*n;
+  int column = std::min(static_cast<int>(u), n - 1);
+  return (u - column < prob_[column]) ? column : alias_[column];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The number of timesteps skipped before each event is geometric (the number
+// of failures before the first success)
+std::vector<int> GeometricSchedule(double prob, int t_start, int t_end,
+				   RNGStream& rng) {
+  std::vector<int> times;
+  if (prob <= 0) {
+    return times;
+  }
+  if (prob >= 1) {
+    for (int t = t_start; t < t_end; t++) {
+      times.push_back(t);
+    }
+    return times;
+  }
+  std::geometric_distribution<int> skip(prob);
+  for (long long t = t_start + (long long)skip(rng.engine()); t < t_end;
+       t += 1 + (long long)skip(rng.engine())) {
+    times.push_back(t);
+  }
+  return times;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 /*
 bool EveryRandomXTimestep(int frequency) {
@@ -165,27 +421,64 @@ double RNG_Integer(double min, double max, int rng_seed) {
   return tRan;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Map the input file name of a curve onto its enum value
+YValFunction ParseYValFunction(const std::string& function) {
+  if (function == "Constant" || function == "constant"){
+    return kConstantFn;
+  } else if (function == "Linear" || function == "linear"){
+    return kLinearFn;
+  } else if (function == "Power" || function == "power"){
+    return kPowerFn;
+  } else if (function == "Bounded_Power" || function == "bounded_power"){
+    return kBoundedPowerFn;
+  } else if (function == "Step" || function == "step"){
+    return kStepFn;
+  }
+  return kUnknownFn;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+SocialBehavior ParseSocialBehavior(const std::string& behavior) {
+  if (behavior.empty() || behavior == "None") {
+    return kNoBehavior;
+  } else if (behavior == "Every") {
+    return kEveryBehavior;
+  } else if (behavior == "Random") {
+    return kRandomBehavior;
+  } else if (behavior == "Reference") {
+    return kReferenceBehavior;
+  }
+  return kUnknownBehavior;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // For various types of x_val varying curves, calculate y for some x
 // Constants = [y_int, (slope or y_final), (t_change)]
   double CalcYVal(std::string function, std::vector<double> constants,
 		  double x_val) {
+    return CalcYVal(ParseYValFunction(function), constants, x_val);
+  }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  double CalcYVal(YValFunction function, const std::vector<double>& constants,
+		  double x_val) {
 
     double curr_y;
     
-    if (function == "Constant" || function == "constant"){
+    if (function == kConstantFn){
       if (constants.size() < 1) {
 	throw "incorrect number of equation parameters";
       } else {
 	curr_y = constants[0];
       }
-    } else if (function == "Linear" || function == "linear"){
+    } else if (function == kLinearFn){
       if (constants.size() < 2) {
 	throw "incorrect number of equation parameters";
       } else {
 	curr_y = constants[0] + constants[1]*x_val;
       }
-    } else if (function == "Power" || function == "power"){
+    } else if (function == kPowerFn){
       // If powerlaw has only one constant, then that is the power (A)
       // Bx^A  and B is assumed to be 1.
       double c_b = 1;
@@ -195,7 +488,7 @@ double RNG_Integer(double min, double max, int rng_seed) {
 	c_b = constants[1];
       } 
       curr_y = c_b*(pow( x_val, constants[0]));
-    } else if (function == "Bounded_Power" || function == "bounded_power"){
+    } else if (function == kBoundedPowerFn){
       // Must be defined with all vals below
       // (Bx^A)+C, [D,E]
       // Where D is lower bound and E is upper bound. y for any x vals < D is
@@ -218,7 +511,7 @@ double RNG_Integer(double min, double max, int rng_seed) {
 	  curr_y = c_c + (c_b*(pow(x_val, c_a)));
 	}
       }
-    } else if (function == "Step" || function == "step"){
+    } else if (function == kStepFn){
       if (constants.size() < 3) {
 	throw "incorrect number of equation parameters";
       } else {
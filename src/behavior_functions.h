@@ -1,6 +1,7 @@
 #ifndef MBMORE_SRC_BEHAVIOR_FUNCTIONS_H_
 #define MBMORE_SRC_BEHAVIOR_FUNCTIONS_H_
 
+#include <random>
 #include <string>
 #include <vector>
 
@@ -22,6 +23,85 @@ bool EveryRandomXTimestep(int frequency, int rng_seed);
 // 
 bool XLikely(double prob, int rng_seed);
 
+// An independent random number stream owned by a single agent. Unlike the
+// functions above, which share the global rand() sequence, a stream can be
+// used from any thread and its sequence depends only on its own seed.
+class RNGStream {
+ public:
+  RNGStream();
+
+  // Seed on current system time if rng_seed is -1, otherwise on rng_seed.
+  // stream_id (eg. the agent id) gives each agent a distinct sequence for
+  // the same rng_seed.
+  void Seed(int rng_seed, int stream_id);
+
+  // uniformly distributed on [0, 1)
+  double Uniform();
+
+  // Standard normal deviate (mean 0, sigma 1), using the ziggurat method of
+  // Marsaglia and Tsang (2000). Almost all samples cost one integer draw, a
+  // table lookup and a multiply.
+  double Normal();
+
+  // Fill out[0] ... out[n-1] with normal deviates of the given mean and sigma
+  void FillNormal(double mean, double sigma, double* out, int n);
+
+  std::mt19937& engine() { return engine_; }
+
+ private:
+  std::mt19937 engine_;
+};
+
+// XLikely drawing from an agent's own stream
+bool XLikely(double prob, RNGStream& rng);
+
+// Normally distributed value drawn from an agent's own stream. If sigma is
+// zero, mean is returned without drawing.
+double RNG_NormalDist(double mean, double sigma, RNGStream& rng);
+
+// Normally distributed value restricted to [lower, upper], drawn by exact
+// rejection sampling (Robert, 1995) so that no probability mass is piled up
+// at the bounds. If sigma is zero (or the bounds coincide) the mean is clamped
+// to the bounds without drawing.
+double RNG_TruncNormal(double mean, double sigma, double lower, double upper,
+		       RNGStream& rng);
+
+// Uniformly chosen integer in [min, max), drawn from an agent's own stream
+int RNG_Integer(int min, int max, RNGStream& rng);
+
+// Number of successes in n_trials independent trials that each succeed with
+// probability prob. Equivalent to counting XLikely(prob, rng) over n_trials
+// calls, in a single draw.
+int RNG_Binomial(int n_trials, double prob, RNGStream& rng);
+
+// Samples an index in [0, n) with probability proportional to its weight in
+// constant time, using the alias method (Vose, 1991). Building the table is
+// O(n). Weights must be non-negative with a positive sum.
+class AliasTable {
+ public:
+  AliasTable() {}
+
+  void Build(const std::vector<double>& weights);
+
+  // Index drawn from a built, non-empty table
+  int Sample(RNGStream& rng) const;
+
+  int size() const { return prob_.size(); }
+
+ private:
+  // probability of keeping the column drawn, and the index it otherwise
+  // aliases to
+  std::vector<double> prob_;
+  std::vector<int> alias_;
+};
+
+// All timesteps in [t_start, t_end) on which an event that occurs on each
+// timestep independently with probability prob happens, in increasing order.
+// Drawn up front from geometric inter-arrival times, so the cost depends on
+// the number of events rather than the number of timesteps.
+std::vector<int> GeometricSchedule(double prob, int t_start, int t_end,
+				   RNGStream& rng);
+
 // returns a randomly generated number from a
 // normal distribution defined by mean and
 // sigma (full-width-half-max)
@@ -35,10 +115,45 @@ double RNG_NormalDist(double mean, double sigma, int rng_seed);
 
 double RNG_Integer(double min, double max, int rng_seed);
 
+// Time-varying curve types understood by CalcYVal. Input files name them
+// with strings, which are parsed once into this enum so that evaluating a
+// curve every timestep does not require string comparisons.
+enum YValFunction {
+  kConstantFn,
+  kLinearFn,
+  kPowerFn,
+  kBoundedPowerFn,
+  kStepFn,
+  kUnknownFn
+};
+
+// Converts a function name from the input file ("Linear", "linear", etc.)
+// into its YValFunction. Unrecognized names return kUnknownFn.
+YValFunction ParseYValFunction(const std::string& function);
+
+// Social behaviors that decide when a facility trades. Input files name them
+// with strings, which are parsed once into this enum when a facility is built.
+enum SocialBehavior {
+  kNoBehavior,
+  kEveryBehavior,
+  kRandomBehavior,
+  kReferenceBehavior,
+  kUnknownBehavior
+};
+
+// Converts a behavior name from the input file ("None", "Every", "Random",
+// "Reference") into its SocialBehavior. An empty name is kNoBehavior, and
+// unrecognized names return kUnknownBehavior.
+SocialBehavior ParseSocialBehavior(const std::string& behavior);
+
 // For various types of time varying curves, calculate y for some x
 double CalcYVal(std::string function, std::vector<double> constants,
 		double x_val);
 
+// Same as above, for a function type that has already been parsed
+double CalcYVal(YValFunction function, const std::vector<double>& constants,
+		double x_val);
+
 // Convert probability integrated over n_timesteps (L, N) to a probability (P)
 // at single time, by solving for P:  L = 1 - (1-P)^N 
 double ProbPerTime(double xval, double n_timesteps);
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
 #include "behavior_functions.h"
 
 #include "agent_tests.h"
@@ -107,6 +112,145 @@ TEST(Behavior_Functions_Test, XLikely){
 }
 
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A stream is reproducible for the same seed and stream id, distinct for a
+// different stream id, and unaffected by draws from any other stream.
+TEST(Behavior_Functions_Test, TestRNGStream) {
+  RNGStream a;
+  RNGStream b;
+  RNGStream c;
+  a.Seed(42, 7);
+  b.Seed(42, 7);
+  c.Seed(42, 8);
+
+  int n_same = 0;
+  int n_true = 0;
+  int n_draws = 10000;
+  for (int i = 0; i < n_draws; i++) {
+    double u = a.Uniform();
+    c.Uniform();
+    EXPECT_DOUBLE_EQ(u, b.Uniform());
+    EXPECT_GE(u, 0.0);
+    EXPECT_LT(u, 1.0);
+    RNGStream d;
+    d.Seed(42, 8);
+    if (d.Uniform() == u) {
+      n_same++;
+    }
+    if (XLikely(0.25, b)) {
+      n_true++;
+    }
+    a.Uniform();
+  }
+  EXPECT_EQ(0, n_same);
+  EXPECT_NEAR(0.25, double(n_true)/n_draws, 0.02);
+
+  RNGStream never;
+  never.Seed(1, 0);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_FALSE(XLikely(0.0, never));
+    EXPECT_TRUE(XLikely(1.0, never));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A single binomial draw should match counting n independent XLikely calls:
+// mean n*p and variance n*p*(1-p), within 5%.
+TEST(Behavior_Functions_Test, TestBinomial) {
+  RNGStream rng;
+  rng.Seed(3, 0);
+
+  EXPECT_EQ(0, RNG_Binomial(1000, 0.0, rng));
+  EXPECT_EQ(1000, RNG_Binomial(1000, 1.0, rng));
+  EXPECT_EQ(0, RNG_Binomial(0, 0.5, rng));
+
+  int n_trials = 1000;
+  double prob = 0.1;
+  int n_draws = 5000;
+  double sum = 0;
+  double sum_sq = 0;
+  for (int i = 0; i < n_draws; i++) {
+    int k = RNG_Binomial(n_trials, prob, rng);
+    EXPECT_GE(k, 0);
+    EXPECT_LE(k, n_trials);
+    sum += k;
+    sum_sq += double(k)*k;
+  }
+  double mean = sum/n_draws;
+  double var = sum_sq/n_draws - mean*mean;
+  EXPECT_NEAR(n_trials*prob, mean, 0.05*n_trials*prob);
+  EXPECT_NEAR(n_trials*prob*(1 - prob), var, 0.05*n_trials*prob*(1 - prob));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Scheduled event times are increasing and within range, and occur on
+// about prob of the timesteps
+TEST(Behavior_Functions_Test, TestGeometricSchedule) {
+  RNGStream rng;
+  rng.Seed(5, 0);
+
+  EXPECT_TRUE(GeometricSchedule(0.0, 0, 100, rng).empty());
+  std::vector<int> every = GeometricSchedule(1.0, 3, 8, rng);
+  ASSERT_EQ(5, static_cast<int>(every.size()));
+  EXPECT_EQ(3, every[0]);
+  EXPECT_EQ(7, every[4]);
+
+  int t_start = 10;
+  int t_end = 100010;
+  double prob = 0.2;
+  std::vector<int> times = GeometricSchedule(prob, t_start, t_end, rng);
+  for (int i = 0; i < times.size(); i++) {
+    EXPECT_GE(times[i], t_start);
+    EXPECT_LT(times[i], t_end);
+    if (i > 0) {
+      EXPECT_GT(times[i], times[i - 1]);
+    }
+  }
+  EXPECT_NEAR(prob, double(times.size())/(t_end - t_start), 0.05*prob);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Each index of an alias table is drawn in proportion to its weight, and an
+// index with zero weight is never drawn
+TEST(Behavior_Functions_Test, TestAliasTable) {
+  RNGStream rng;
+  rng.Seed(17, 0);
+
+  double w[5] = {1.0, 0.0, 3.0, 0.5, 5.5};
+  std::vector<double> weights(w, w + 5);
+  AliasTable table;
+  table.Build(weights);
+  ASSERT_EQ(5, table.size());
+
+  int n_samples = 200000;
+  std::vector<int> counts(5, 0);
+  for (int i = 0; i < n_samples; i++) {
+    int idx = table.Sample(rng);
+    ASSERT_GE(idx, 0);
+    ASSERT_LT(idx, 5);
+    counts[idx]++;
+  }
+  for (int i = 0; i < 5; i++) {
+    double expected = w[i]/10.0;
+    EXPECT_NEAR(expected, double(counts[i])/n_samples, 0.005) << "index " << i;
+  }
+  EXPECT_EQ(0, counts[1]);
+
+  // equal weights are uniform, and a single entry is always chosen
+  AliasTable uniform;
+  uniform.Build(std::vector<double>(4, 2.0));
+  std::vector<int> uniform_counts(4, 0);
+  for (int i = 0; i < n_samples; i++) {
+    uniform_counts[uniform.Sample(rng)]++;
+  }
+  for (int i = 0; i < 4; i++) {
+    EXPECT_NEAR(0.25, double(uniform_counts[i])/n_samples, 0.005);
+  }
+  AliasTable single;
+  single.Build(std::vector<double>(1, 0.3));
+  EXPECT_EQ(0, single.Sample(rng));
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Mean and Standard deviation of a Normal Gaussian Distribution should be
 // within 5% of the requested value.
@@ -138,6 +282,167 @@ TEST(Behavior_Functions_Test, TestNormalDist) {
   
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Ziggurat samples should match the moments of a normal distribution and
+// populate the tails (including beyond the base layer at 3.44 sigma) at the
+// expected rates. The batch fill draws the same sequence as single samples.
+TEST(Behavior_Functions_Test, TestZigguratNormal) {
+  RNGStream rng;
+  rng.Seed(11, 0);
+
+  int n_samples = 1000000;
+  std::vector<double> record(n_samples);
+  rng.FillNormal(0.0, 1.0, &record[0], n_samples);
+
+  double sum = 0;
+  double sum_sq = 0;
+  double sum_4 = 0;
+  int beyond_2 = 0;
+  int beyond_tail = 0;
+  for (int i = 0; i < n_samples; i++) {
+    double x = record[i];
+    sum += x;
+    sum_sq += x*x;
+    sum_4 += x*x*x*x;
+    if (std::fabs(x) > 2.0) {
+      beyond_2++;
+    }
+    if (std::fabs(x) > 3.5) {
+      beyond_tail++;
+    }
+  }
+  double mu = sum/n_samples;
+  double var = sum_sq/n_samples - mu*mu;
+
+  EXPECT_NEAR(0.0, mu, 0.005);
+  EXPECT_NEAR(1.0, var, 0.005);
+  EXPECT_NEAR(3.0, sum_4/n_samples, 0.05);
+  // P(|x| > 2) = 0.0455, P(|x| > 3.5) = 4.65e-4
+  EXPECT_NEAR(0.0455, double(beyond_2)/n_samples, 0.001);
+  EXPECT_NEAR(4.65e-4, double(beyond_tail)/n_samples, 1e-4);
+
+  RNGStream single;
+  RNGStream batch;
+  single.Seed(3, 1);
+  batch.Seed(3, 1);
+  std::vector<double> filled(100);
+  batch.FillNormal(10.0, 2.0, &filled[0], filled.size());
+  for (int i = 0; i < filled.size(); i++) {
+    EXPECT_DOUBLE_EQ(filled[i], RNG_NormalDist(10.0, 2.0, single));
+  }
+  EXPECT_EQ(5.0, RNG_NormalDist(5.0, 0.0, single));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Truncated normal samples stay within the bounds without collecting at them,
+// and match the analytic mean and variance of the truncated distribution for
+// central, one-sided, narrow and asymmetric intervals.
+TEST(Behavior_Functions_Test, TestTruncNormal) {
+  RNGStream rng;
+  rng.Seed(13, 0);
+  int n_samples = 200000;
+  double inf = std::numeric_limits<double>::infinity();
+
+  // lower, upper, analytic mean and variance for mean 0, sigma 1
+  double cases[5][4] = {
+    {-1.0, 1.0, 0.0, 0.291125},
+    {2.0, inf, 2.373216, 0.114279},
+    {1.0, 1.1, 1.049125, 0.000833},
+    {-0.5, 3.0, 0.503734, 0.471908},
+    {-inf, -3.0, -3.283099, 0.070559}
+  };
+  for (int c = 0; c < 5; c++) {
+    double lower = cases[c][0];
+    double upper = cases[c][1];
+    double sum = 0;
+    double sum_sq = 0;
+    int at_bound = 0;
+    for (int i = 0; i < n_samples; i++) {
+      double x = RNG_TruncNormal(0.0, 1.0, lower, upper, rng);
+      ASSERT_GE(x, lower);
+      ASSERT_LE(x, upper);
+      if ((x == lower) || (x == upper)) {
+	at_bound++;
+      }
+      sum += x;
+      sum_sq += x*x;
+    }
+    double mu = sum/n_samples;
+    double var = sum_sq/n_samples - mu*mu;
+    EXPECT_NEAR(cases[c][2], mu, 0.01) << "interval " << c;
+    EXPECT_NEAR(cases[c][3], var, 0.02*cases[c][3] + 1e-5) << "interval " << c;
+    EXPECT_EQ(0, at_bound) << "interval " << c;
+  }
+
+  // shifted and scaled like a tails assay, and degenerate inputs
+  double x = RNG_TruncNormal(0.003, 0.0005, 0.0025, 0.0035, rng);
+  EXPECT_GE(x, 0.0025);
+  EXPECT_LE(x, 0.0035);
+  EXPECT_EQ(0.0035, RNG_TruncNormal(0.004, 0.0, 0.0025, 0.0035, rng));
+  EXPECT_EQ(0.003, RNG_TruncNormal(0.002, 0.001, 0.003, 0.003, rng));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The polar Box-Muller method of the legacy RNG_NormalDist, keeping one of
+// each pair of deviates as it does, but drawing from a stream so that the
+// global rand() state is left alone
+static double BoxMullerNormal(double mean, double sigma, RNGStream& rng) {
+  double x, y, r;
+  do {
+    x = 2.0*rng.Uniform() - 1;
+    y = 2.0*rng.Uniform() - 1;
+    r = x*x + y*y;
+  } while (r == 0.0 || r > 1.0);
+  return x*std::sqrt(-2.0*std::log(r)/r)*sigma + mean;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Benchmark (run with --gtest_also_run_disabled_tests) of the Box-Muller
+// sampler that RandomEnrich and RandomSink formerly called every timestep,
+// against the ziggurat one sample per call and as a batch fill. Times are
+// reported as test properties.
+TEST(Behavior_Functions_Test, DISABLED_NormalSamplerThroughput) {
+  int n_samples = 2000000;
+  std::vector<double> record(n_samples);
+
+  typedef std::chrono::steady_clock clock;
+  RNGStream legacy;
+  legacy.Seed(7, 0);
+  clock::time_point start = clock::now();
+  for (int i = 0; i < n_samples; i++) {
+    record[i] = BoxMullerNormal(0.0, 1.0, legacy);
+  }
+  double legacy_ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count() / n_samples;
+  double legacy_sum = std::accumulate(record.begin(), record.end(), 0.0);
+
+  RNGStream single;
+  single.Seed(7, 0);
+  start = clock::now();
+  for (int i = 0; i < n_samples; i++) {
+    record[i] = RNG_NormalDist(0.0, 1.0, single);
+  }
+  double single_ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count() / n_samples;
+  double single_sum = std::accumulate(record.begin(), record.end(), 0.0);
+
+  RNGStream batch;
+  batch.Seed(7, 0);
+  start = clock::now();
+  batch.FillNormal(0.0, 1.0, &record[0], n_samples);
+  double batch_ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count() / n_samples;
+  double batch_sum = std::accumulate(record.begin(), record.end(), 0.0);
+
+  RecordProperty("box_muller_ps_per_sample", int(1000*legacy_ns));
+  RecordProperty("ziggurat_ps_per_sample", int(1000*single_ns));
+  RecordProperty("ziggurat_batch_ps_per_sample", int(1000*batch_ns));
+
+  EXPECT_LT(std::fabs(legacy_sum/n_samples), 0.01);
+  // the same stream either way, so the sums only differ by rounding
+  EXPECT_NEAR(single_sum, batch_sum, 1e-6*n_samples);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Each number in the range from min to max should be selected with equal
 // frequency to within tolerance (5%)
@@ -249,6 +554,41 @@ TEST(Behavior_Functions_Test, TestCalcYVal) {
 
   }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Parsed function types should give the same curves as their string names
+TEST(Behavior_Functions_Test, TestParseYValFunction) {
+  double tol = 1e-6;
+  double x_val = 3;
+
+  EXPECT_EQ(kConstantFn, ParseYValFunction("Constant"));
+  EXPECT_EQ(kLinearFn, ParseYValFunction("linear"));
+  EXPECT_EQ(kPowerFn, ParseYValFunction("Power"));
+  EXPECT_EQ(kBoundedPowerFn, ParseYValFunction("bounded_power"));
+  EXPECT_EQ(kStepFn, ParseYValFunction("step"));
+  EXPECT_EQ(kUnknownFn, ParseYValFunction("StateB"));
+
+  std::vector<double> constants;
+  constants.push_back(2);
+  constants.push_back(0.5);
+  constants.push_back(5);
+  EXPECT_NEAR(CalcYVal("linear", constants, x_val),
+	      CalcYVal(kLinearFn, constants, x_val), tol);
+  EXPECT_NEAR(CalcYVal("step", constants, x_val),
+	      CalcYVal(kStepFn, constants, x_val), tol);
+  EXPECT_THROW(CalcYVal(kUnknownFn, constants, x_val), const char*);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Behavior names are parsed once into the SocialBehavior enum
+TEST(Behavior_Functions_Test, TestParseSocialBehavior) {
+  EXPECT_EQ(kNoBehavior, ParseSocialBehavior("None"));
+  EXPECT_EQ(kNoBehavior, ParseSocialBehavior(""));
+  EXPECT_EQ(kEveryBehavior, ParseSocialBehavior("Every"));
+  EXPECT_EQ(kRandomBehavior, ParseSocialBehavior("Random"));
+  EXPECT_EQ(kReferenceBehavior, ParseSocialBehavior("Reference"));
+  EXPECT_EQ(kUnknownBehavior, ParseSocialBehavior("Sometimes"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 
   
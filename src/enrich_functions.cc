@@ -7,6 +7,7 @@
 #include <iterator>
 #include "cyclus.h"
 #include "enrich_functions.h"
+#include "mbmore_log.h"
 
 namespace mbmore {
 
@@ -421,7 +422,8 @@ std::pair<int, double> DesignCascade(double design_feed,
                                    n_stages, feed_flows);
     machines_needed = FindTotalMachines(stage_info);
     std::pair<int, double> last_stage = stage_info.back();
-    std::cout << "# in last stage " << last_stage.first << std::endl;
+    MBMORE_LOG(cyclus::LEV_DEBUG3, "EnrFac") << "# in last stage "
+					     << last_stage.first;
     // If cannot converge on a cascade with allowable number of centrifuges
     if (ntries >= max_tries) {
       throw cyclus::ValueError(
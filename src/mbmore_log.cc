@@ -0,0 +1,12 @@
+// Implements the mbmore logging helpers
+#include "mbmore_log.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool LogEnabled(cyclus::LogLevel level) {
+  return (level <= cyclus::MBMORE_MAX_LOG_LEVEL) &&
+    (level <= cyclus::Logger::ReportLevel());
+}
+
+}  // namespace mbmore
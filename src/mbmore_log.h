@@ -0,0 +1,32 @@
+#ifndef MBMORE_SRC_MBMORE_LOG_H_
+#define MBMORE_SRC_MBMORE_LOG_H_
+
+#include "cyclus.h"
+
+// Most verbose log level compiled into mbmore. Messages above this level are
+// removed at compile time, including the formatting of their arguments.
+// Set with the MBMORE_MAX_LOG_LEVEL CMake variable (eg. LEV_INFO5 for
+// production runs). Defaults to keeping every level.
+#ifndef MBMORE_MAX_LOG_LEVEL
+#define MBMORE_MAX_LOG_LEVEL LEV_DEBUG5
+#endif
+
+// Same usage as the cyclus LOG macro:
+//   MBMORE_LOG(cyclus::LEV_DEBUG2, "SnkFac") << "some message " << value;
+// The compile-time level is checked first, then the run-time verbosity
+// (cyclus --verb), both before any of the streamed values are formatted.
+#define MBMORE_LOG(level, prefix)                                   \
+  if (((level) > cyclus::MBMORE_MAX_LOG_LEVEL) ||                   \
+      ((level) > cyclus::Logger::ReportLevel())) {                  \
+  } else                                                            \
+    cyclus::Logger().Get(level, prefix)
+
+namespace mbmore {
+
+// True if a message at this level would be written, for guarding any work
+// done only to build a log message
+bool LogEnabled(cyclus::LogLevel level);
+
+}  // namespace mbmore
+
+#endif  // MBMORE_SRC_MBMORE_LOG_H_
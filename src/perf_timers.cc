@@ -0,0 +1,99 @@
+// Implements the PerfRegistry class
+#include "perf_timers.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+PerfRegistry& PerfRegistry::Instance() {
+  static PerfRegistry registry;
+  return registry;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+PerfRegistry::PerfRegistry()
+    : step_ctx_(NULL),
+      step_(-1),
+      n_ticked_(0),
+      n_tocked_(0) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+PerfStat* PerfRegistry::Stat(const std::string& archetype,
+                             const std::string& phase) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<PerfStat>& stat = stats_[Key(archetype, phase)];
+  if (!stat) {
+    stat.reset(new PerfStat());
+  }
+  return stat.get();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::Ticked(cyclus::Context* ctx) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartStep_(ctx);
+  n_ticked_++;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::Tocked(cyclus::Context* ctx) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartStep_(ctx);
+  n_tocked_++;
+  // agents deployed during this timestep only tick from the next one, so
+  // every agent that ticked has now tocked
+  if ((ctx->time() >= ctx->sim_info().duration - 1) &&
+      (n_tocked_ >= n_ticked_)) {
+    Record_(ctx);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::StartStep_(cyclus::Context* ctx) {
+  if ((ctx != step_ctx_) || (ctx->time() != step_)) {
+    step_ctx_ = ctx;
+    step_ = ctx->time();
+    n_ticked_ = 0;
+    n_tocked_ = 0;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::Record(cyclus::Context* ctx) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record_(ctx);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::Record_(cyclus::Context* ctx) {
+  std::map<Key, std::unique_ptr<PerfStat> >::const_iterator it;
+  for (it = stats_.begin(); it != stats_.end(); ++it) {
+    long long calls = it->second->calls.load();
+    if (calls == 0) {
+      continue;
+    }
+    ctx->NewDatum("MbmorePerf")
+        ->AddVal("Archetype", it->first.first)
+        ->AddVal("Phase", it->first.second)
+        ->AddVal("Calls", static_cast<int>(calls))
+        ->AddVal("Seconds", it->second->nanos.load() * 1e-9)
+        ->Record();
+  }
+  Reset_();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Reset_();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfRegistry::Reset_() {
+  std::map<Key, std::unique_ptr<PerfStat> >::iterator it;
+  for (it = stats_.begin(); it != stats_.end(); ++it) {
+    it->second->calls.store(0);
+    it->second->nanos.store(0);
+  }
+}
+
+}  // namespace mbmore
@@ -0,0 +1,151 @@
+#ifndef MBMORE_SRC_PERF_TIMERS_H_
+#define MBMORE_SRC_PERF_TIMERS_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "cyclus.h"
+
+// Wall time spent in each agent phase, summed over every agent of an
+// archetype and written to the MbmorePerf table (Archetype, Phase, Calls,
+// Seconds) at the end of the simulation. Timing is only compiled in when
+// MBMORE_PERF is defined (the MBMORE_PERF CMake option), otherwise the macros
+// below are empty.
+//
+// Each timed phase is a scope:
+//   MBMORE_PERF_SCOPE("CascadeEnrich", "GetMatlBids");
+// and each timed archetype marks its Tick and Tock, so that the table is
+// recorded once every agent has finished the last timestep:
+//   void CascadeEnrich::Tick() {
+//     MBMORE_PERF_TICK("CascadeEnrich", context());
+//     ...
+//   void CascadeEnrich::Tock() {
+//     MBMORE_PERF_TOCK("CascadeEnrich", context());
+//     ...
+// Times are inclusive: a phase called from another timed phase is counted in
+// both.
+#ifdef MBMORE_PERF
+
+#define MBMORE_PERF_CONCAT_(a, b) a##b
+#define MBMORE_PERF_CONCAT(a, b) MBMORE_PERF_CONCAT_(a, b)
+
+#define MBMORE_PERF_SCOPE(archetype, phase)                             \
+  static mbmore::PerfStat* const MBMORE_PERF_CONCAT(mbmore_perf_stat_,  \
+                                                    __LINE__) =         \
+      mbmore::PerfRegistry::Instance().Stat(archetype, phase);          \
+  mbmore::ScopedPerfTimer MBMORE_PERF_CONCAT(mbmore_perf_timer_,        \
+                                             __LINE__)(                 \
+      MBMORE_PERF_CONCAT(mbmore_perf_stat_, __LINE__))
+
+#define MBMORE_PERF_TICK(archetype, ctx)                \
+  mbmore::PerfRegistry::Instance().Ticked(ctx);         \
+  MBMORE_PERF_SCOPE(archetype, "Tick")
+
+// the guard is declared first so that it reports the Tock after the Tock
+// timer has stopped
+#define MBMORE_PERF_TOCK(archetype, ctx)                \
+  mbmore::PerfTockGuard mbmore_perf_tock_guard_(ctx);   \
+  MBMORE_PERF_SCOPE(archetype, "Tock")
+
+#else
+
+#define MBMORE_PERF_SCOPE(archetype, phase)
+#define MBMORE_PERF_TICK(archetype, ctx)
+#define MBMORE_PERF_TOCK(archetype, ctx)
+
+#endif  // MBMORE_PERF
+
+namespace mbmore {
+
+// Calls and total wall time of one phase of one archetype. Updated
+// concurrently by the InteractRegion decision threads.
+struct PerfStat {
+  PerfStat() : calls(0), nanos(0) {}
+
+  std::atomic<long long> calls;
+  std::atomic<long long> nanos;
+};
+
+// Adds the time between its construction and destruction to a PerfStat
+class ScopedPerfTimer {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  explicit ScopedPerfTimer(PerfStat* stat)
+      : stat_(stat), start_(Clock::now()) {}
+
+  ~ScopedPerfTimer() {
+    long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start_).count();
+    stat_->nanos.fetch_add(ns, std::memory_order_relaxed);
+    stat_->calls.fetch_add(1, std::memory_order_relaxed);
+  }
+
+ private:
+  PerfStat* stat_;
+  Clock::time_point start_;
+};
+
+// The PerfStats of every timed phase, shared by all agents in the process
+class PerfRegistry {
+ public:
+  static PerfRegistry& Instance();
+
+  // The stat for a phase of an archetype, created on first use. The pointer
+  // stays valid (and is only zeroed by Reset) for the life of the process.
+  PerfStat* Stat(const std::string& archetype, const std::string& phase);
+
+  // Called at the start of the Tick and the end of the Tock of each timed
+  // agent. The Tock that completes the last timestep of the simulation
+  // records the MbmorePerf table and resets the stats.
+  void Ticked(cyclus::Context* ctx);
+  void Tocked(cyclus::Context* ctx);
+
+  // Write one MbmorePerf row per phase that was called, then reset
+  void Record(cyclus::Context* ctx);
+
+  // Zero every stat
+  void Reset();
+
+ private:
+  PerfRegistry();
+
+  typedef std::pair<std::string, std::string> Key;
+
+  // Restart the Tick/Tock counts when a new timestep (or simulation) starts
+  void StartStep_(cyclus::Context* ctx);
+
+  // Record and Reset, with the mutex held
+  void Record_(cyclus::Context* ctx);
+  void Reset_();
+
+  std::mutex mutex_;
+  std::map<Key, std::unique_ptr<PerfStat> > stats_;
+
+  // timestep being counted, and how many timed agents have ticked and
+  // tocked in it
+  cyclus::Context* step_ctx_;
+  int step_;
+  int n_ticked_;
+  int n_tocked_;
+};
+
+// Reports the Tock of a timed agent to the PerfRegistry when it goes out of
+// scope (see MBMORE_PERF_TOCK)
+class PerfTockGuard {
+ public:
+  explicit PerfTockGuard(cyclus::Context* ctx) : ctx_(ctx) {}
+  ~PerfTockGuard() { PerfRegistry::Instance().Tocked(ctx_); }
+
+ private:
+  cyclus::Context* ctx_;
+};
+
+}  // namespace mbmore
+
+#endif  // MBMORE_SRC_PERF_TIMERS_H_
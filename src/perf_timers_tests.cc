@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "context.h"
+#include "rec_backend.h"
+#include "recorder.h"
+#include "timer.h"
+
+#include "perf_timers.h"
+
+namespace mbmore {
+
+namespace {
+
+// Keeps the MbmorePerf rows
+class PerfCapture : public cyclus::RecBackend {
+ public:
+  virtual void Notify(cyclus::DatumList data) {
+    for (int i = 0; i < data.size(); i++) {
+      if (data[i]->title() == "MbmorePerf") {
+        rows.push_back(data[i]->vals());
+      }
+    }
+  }
+  virtual std::string Name() { return "perf_capture"; }
+  virtual void Flush() {}
+  virtual void Close() {}
+
+  std::vector<cyclus::Datum::Vals> rows;
+};
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Timers add their calls and time to one shared stat per archetype phase
+TEST(PerfTimersTest, TimersAccumulate) {
+  PerfRegistry& registry = PerfRegistry::Instance();
+  registry.Reset();
+
+  PerfStat* stat = registry.Stat("PerfTest", "GetMatlBids");
+  EXPECT_EQ(stat, registry.Stat("PerfTest", "GetMatlBids"));
+  EXPECT_NE(stat, registry.Stat("PerfTest", "Enrich_"));
+  EXPECT_NE(stat, registry.Stat("OtherTest", "GetMatlBids"));
+
+  for (int i = 0; i < 3; i++) {
+    ScopedPerfTimer timer(stat);
+  }
+  EXPECT_EQ(3, stat->calls.load());
+  EXPECT_GE(stat->nanos.load(), 0);
+
+  registry.Reset();
+  EXPECT_EQ(0, stat->calls.load());
+  EXPECT_EQ(0, stat->nanos.load());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// The table is recorded once every agent that ticked in the last timestep has
+// tocked, with a row for each phase that was called
+TEST(PerfTimersTest, RecordedAfterLastTock) {
+  PerfCapture back;
+  cyclus::Recorder rec;
+  rec.RegisterBackend(&back);
+  cyclus::Timer ti;
+  cyclus::Context ctx(&ti, &rec);
+  ctx.InitSim(cyclus::SimInfo(1));
+
+  PerfRegistry& registry = PerfRegistry::Instance();
+  registry.Reset();
+  PerfStat* stat = registry.Stat("PerfTest", "GetMatlBids");
+  registry.Stat("PerfTest", "Enrich_");
+
+  registry.Ticked(&ctx);
+  registry.Ticked(&ctx);
+  {
+    ScopedPerfTimer timer(stat);
+  }
+  {
+    ScopedPerfTimer timer(stat);
+  }
+  registry.Tocked(&ctx);
+  rec.Flush();
+  EXPECT_EQ(0, back.rows.size());
+
+  registry.Tocked(&ctx);
+  rec.Flush();
+  ASSERT_EQ(1, back.rows.size());
+  ASSERT_EQ(4, back.rows[0].size());
+  EXPECT_EQ("PerfTest", back.rows[0][0].second.cast<std::string>());
+  EXPECT_EQ("GetMatlBids", back.rows[0][1].second.cast<std::string>());
+  EXPECT_EQ(2, back.rows[0][2].second.cast<int>());
+  EXPECT_GE(back.rows[0][3].second.cast<double>(), 0);
+  EXPECT_EQ(0, stat->calls.load());
+  rec.Close();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Benchmark (run with --gtest_also_run_disabled_tests) of one timed scope,
+// which is paid on every call of a timed phase when MBMORE_PERF is on. The
+// cost is reported as a test property.
+TEST(PerfTimersTest, DISABLED_TimerOverhead) {
+  typedef std::chrono::steady_clock clock;
+  PerfRegistry& registry = PerfRegistry::Instance();
+  PerfStat* stat = registry.Stat("PerfTest", "Overhead");
+  int n_calls = 1000000;
+
+  clock::time_point start = clock::now();
+  for (int i = 0; i < n_calls; i++) {
+    ScopedPerfTimer timer(stat);
+  }
+  double timer_ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count() / n_calls;
+  EXPECT_EQ(n_calls, stat->calls.load());
+  registry.Reset();
+
+  RecordProperty("timer_ns", static_cast<int>(timer_ns));
+}
+
+}  // namespace mbmore
@@ -0,0 +1,91 @@
+// Implements the WorkerPool class
+#include "worker_pool.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+WorkerPool::WorkerPool(int n_workers)
+    : n_workers_(n_workers < 1 ? 1 : n_workers),
+      work_(NULL),
+      generation_(0),
+      n_running_(0),
+      stop_(false),
+      errors_(n_workers_) {
+  for (int w = 1; w < n_workers_; w++) {
+    threads_.push_back(std::thread(&WorkerPool::Loop_, this, w));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (int t = 0; t < threads_.size(); t++) {
+    threads_[t].join();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void WorkerPool::Run(const std::function<void(int)>& work) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_ = &work;
+    errors_.assign(n_workers_, std::exception_ptr());
+    n_running_ = n_workers_ - 1;
+    generation_++;
+  }
+  start_cv_.notify_all();
+
+  try {
+    work(0);
+  } catch (...) {
+    errors_[0] = std::current_exception();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return n_running_ == 0; });
+    work_ = NULL;
+  }
+  for (int w = 0; w < n_workers_; w++) {
+    if (errors_[w]) {
+      std::rethrow_exception(errors_[w]);
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void WorkerPool::Loop_(int worker) {
+  long long seen = 0;
+  while (true) {
+    const std::function<void(int)>* work;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [this, seen]() {
+        return stop_ || (generation_ != seen);
+      });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+      work = work_;
+    }
+
+    // each worker only writes its own error slot
+    try {
+      (*work)(worker);
+    } catch (...) {
+      errors_[worker] = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--n_running_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+}  // namespace mbmore
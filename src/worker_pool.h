@@ -0,0 +1,58 @@
+#ifndef MBMORE_SRC_WORKER_POOL_H_
+#define MBMORE_SRC_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mbmore {
+
+// A fixed set of threads that run the same piece of work, once per worker,
+// each time Run is called. The threads are started once and wait between
+// runs, so that work done every timestep does not pay for creating threads.
+//
+//   WorkerPool pool(4);
+//   pool.Run([&](int worker) {
+//     for (int i = worker; i < n; i += pool.size()) { ... }
+//   });
+class WorkerPool {
+ public:
+  // @param n_workers number of workers, including the thread calling Run
+  explicit WorkerPool(int n_workers);
+  ~WorkerPool();
+
+  int size() const { return n_workers_; }
+
+  // Call work(w) for every worker w in [0, size()), worker 0 on the calling
+  // thread, and return when all of them have finished
+  // @throws the exception thrown by the lowest numbered worker that failed
+  void Run(const std::function<void(int)>& work);
+
+ private:
+  WorkerPool(const WorkerPool&);
+  WorkerPool& operator=(const WorkerPool&);
+
+  // Body of each pool thread: wait for a run, do its share, repeat
+  void Loop_(int worker);
+
+  int n_workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  // work of the current run, and how many runs have been started
+  const std::function<void(int)>* work_;
+  long long generation_;
+  // pool threads still busy with the current run
+  int n_running_;
+  bool stop_;
+  std::vector<std::exception_ptr> errors_;
+};
+
+}  // namespace mbmore
+
+#endif  // MBMORE_SRC_WORKER_POOL_H_
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "worker_pool.h"
+
+namespace mbmore {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Every worker runs once per Run, and the same threads serve later runs
+TEST(WorkerPoolTest, EachWorkerRunsOnce) {
+  WorkerPool pool(4);
+  ASSERT_EQ(4, pool.size());
+
+  for (int run = 0; run < 50; run++) {
+    std::vector<int> calls(pool.size(), 0);
+    pool.Run([&](int w) { calls[w]++; });
+    for (int w = 0; w < pool.size(); w++) {
+      EXPECT_EQ(1, calls[w]) << "worker " << w << " on run " << run;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Workers split a loop by stride, covering every item exactly once
+TEST(WorkerPoolTest, StridedWork) {
+  WorkerPool pool(3);
+  int n = 100;
+  std::vector<int> items(n, 0);
+  pool.Run([&](int w) {
+    for (int i = w; i < n; i += pool.size()) {
+      items[i] += i;
+    }
+  });
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(i, items[i]);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// A single worker runs on the calling thread
+TEST(WorkerPoolTest, SingleWorker) {
+  WorkerPool pool(0);
+  EXPECT_EQ(1, pool.size());
+  std::thread::id caller = std::this_thread::get_id();
+  std::thread::id ran_on;
+  pool.Run([&](int w) { ran_on = std::this_thread::get_id(); });
+  EXPECT_EQ(caller, ran_on);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Errors reach the caller after every worker has finished, and the pool can
+// still be used afterwards
+TEST(WorkerPoolTest, ErrorsRethrown) {
+  WorkerPool pool(4);
+  std::atomic<int> finished(0);
+  EXPECT_THROW(pool.Run([&](int w) {
+        finished++;
+        if (w == 2) {
+          throw std::runtime_error("worker 2 failed");
+        }
+      }), std::runtime_error);
+  EXPECT_EQ(4, finished.load());
+
+  finished = 0;
+  EXPECT_NO_THROW(pool.Run([&](int w) { finished++; }));
+  EXPECT_EQ(4, finished.load());
+}
+
+}  // namespace mbmore